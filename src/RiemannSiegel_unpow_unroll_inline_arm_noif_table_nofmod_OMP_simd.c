@@ -0,0 +1,4461 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <float.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <omp.h>
+#ifdef __linux__
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define X86_SIMD
+#include <immintrin.h>
+#endif
+
+#ifdef ARM
+#include <armpl.h>
+#endif
+
+#ifndef C_PROG
+#include <cmath>
+#endif
+
+/*************************************************************************
+* *
+
+
+This code computes the number of zeros on the critical line of the Zeta function.
+https://en.wikipedia.org/wiki/Riemann_zeta_function 
+
+This is one of the most important and non resolved problem in mathematics : https://www.science-et-vie.com/article-magazine/voici-les-7-plus-grands-problemes-de-mathematiques-jamais-resolus
+
+This problem has been the subject of one of the most important distributed computing project in the cloud : more than 10000 machines during 2 years. 
+They used this algorithm: very well optimized.
+This project failed, bitten by a smaller team that used a far better algorithm. 
+The code is based on the Thesis of Glendon Ralph Pugh (1992) : https://web.viu.ca/pughg/thesis.d/masters.thesis.pdf
+
+We can optimize the code in numerous ways, and obviously parallelize it. 
+
+Remark: we do not compute the zeros: we count them to check that they are on the Riemann Line.
+Remark: Andrew Odlyzko created a method that is far more efficient but too complex to be the subject of an algorithmetical tuning exercice. 
+
+The exercise is to sample a region on the critical line to count how many times the function changes sign, so that there is at least 1 zero between 2 sampling points.
+Here we use a constant sampling but you can recode entirely the way to proceed.
+
+Only a correct (right) count matters, and the performance.
+
+compile g++ RiemannSiegel.cpp -O -o RiemannSiegel
+--------------------------------------------------------------------------
+./RiemannSiegel 10 1000 100
+I found 649 Zeros in 3.459 seconds     # OK 
+--------------------------------------------------------------------------
+./RiemannSiegel 10 10000 10 
+I found 10142 Zeros in 0.376 seconds     # OK
+--------------------------------------------------------------------------
+./RiemannSiegel 10 100000 10
+I found 137931 Zeros in 6.934 seconds    # INCORRECT
+--------------------------------------------------------------------------
+./RiemannSiegel 10 100000 100
+I found 138069 Zeros in 56.035 seconds   # OK
+--------------------------------------------------------------------------
+RiemannSiegel 10 1000000     need to find : 1747146     zeros
+RiemannSiegel 10 10000000    need to find : 21136125    zeros
+RiemannSiegel 10 100000000   need to find : 248888025   zeros
+RiemannSiegel 10 1000000000  need to find : 2846548032  zeros
+RiemannSiegel 10 10000000000 need to find : 32130158315 zeros
+
+
+The more regions you validate and with the best timing, the more points you get.
+
+The official world record of the zeros computed is 10^13 but with some FFTs and the method from Odlyzsko.
+Compute time 1 year-core so an algortihm 10000*2*40 times more efficient than ZetaGrid's one. 
+
+* *
+*************************************************************************/
+
+typedef unsigned long      ui32;
+typedef unsigned long long ui64;
+
+/*
+	Tables invert_sqrt[j] = 1/sqrt(j) and log_int[j] = log(j), one copy per NUMA node (compute_table)
+	Both live in one mapping (table_alloc), the term j is isq[TAB_STRIDE*j] and lgi[TAB_STRIDE*j] :
+	TABLE_INTERLEAVED=0 : two streams, each 64 bytes aligned
+	TABLE_INTERLEAVED=1 : (1/sqrt(j), log(j)) pairs, one stream for the main sum loops
+*/
+#ifndef TABLE_INTERLEAVED
+#define TABLE_INTERLEAVED 0
+#endif
+
+#if TABLE_INTERLEAVED
+#define TAB_STRIDE 2
+#else
+#define TAB_STRIDE 1
+#endif
+
+typedef struct table_s {
+	double *mem;	// the mapping
+	size_t  bytes;
+	int     mapped;	// mem comes from mmap
+	double *isq;
+	double *lgi;
+} table_t;
+
+int      table_copies = 0;
+table_t *table_copy = NULL;
+static __thread int table_id = -1;	// copy read by the calling thread, -1 : not placed
+
+static inline const double *table_isq(void)
+{
+	return table_copy[(table_id < 0) ? 0 : table_id].isq;
+}
+
+static inline const double *table_lgi(void)
+{
+	return table_copy[(table_id < 0) ? 0 : table_id].lgi;
+}
+
+double dml_micros()
+{
+        static struct timezone tz;
+        static struct timeval  tv;
+        gettimeofday(&tv,&tz);
+        return((tv.tv_sec*1000000.0)+tv.tv_usec);
+}
+
+inline __attribute__((always_inline)) int even(int n)
+{
+	return 1-2*(n&1);
+}
+
+double theta(double t)
+{
+	const double pi = 3.1415926535897932385;
+	double t_div_2 	= t*0.5;
+	double pawt2 	= t*t;
+	double pawt3 	= pawt2*t;
+	double pawt5 	= pawt3*pawt2;
+	double pawt7 	= pawt5*pawt2;
+	double pawt9 	= pawt7*pawt2;
+
+	// return(  t/2.0*log(t/2.0/pi)  -  t/2.0  -  pi/8.0  + 1.0/48.0/t + 7.0/5760.0/pow(t,3.0) + 31.0/80640.0/powl(t,5.0) +127.0/430080.0/powl(t,7.0)+511.0/1216512.0/powl(t,9.0));
+	return(   t_div_2*log(t_div_2/pi)- t_div_2 - pi*0.125 + 1.0/48.0/t + 7.0/5760.0/pawt3      + 31.0/80640.0/pawt5       +127.0/430080.0/pawt7      +511.0/1216512.0/pawt9      );
+	//https://oeis.org/A282898  // numerators
+	//https://oeis.org/A114721  // denominators
+}
+
+/*************************************************************************
+	NUMA placement of the tables
+
+	Every NUMA node running threads gets its own copy of the tables. The
+	copy is filled in parallel by the threads of its node, so its pages
+	are placed on that node by first touch and the main sums only read
+	local memory. A thread reads the copy of the node it was on when the
+	tables were built (table_id). With -b the threads are pinned first
+	(numa_init) so they stay there. The topology is read from /sys, a
+	machine without it is a single node.
+*************************************************************************/
+
+#ifndef MAX_NODES
+#define MAX_NODES 64
+#endif
+
+// 0 : a single copy shared by all the nodes
+#ifndef TABLE_REPLICATE
+#define TABLE_REPLICATE 1
+#endif
+
+typedef enum { BIND_NONE, BIND_COMPACT, BIND_SPREAD } bind_t;
+
+int  numa_nodes = 0;	// 0 : numa_init not done yet
+#ifdef __linux__
+int  cpu_node[CPU_SETSIZE];
+#endif
+
+// Node of the cpu the calling thread runs on
+int current_node(void)
+{
+#ifdef __linux__
+	const int cpu = sched_getcpu();
+	if (cpu >= 0 && cpu < CPU_SETSIZE)
+		return cpu_node[cpu];
+#endif
+	return 0;
+}
+
+/*
+	Reads the nodes of the cpus and, unless BIND_NONE, pins the OpenMP
+	thread i on the i-th cpu allowed to the process : node after node
+	(BIND_COMPACT) or one node after the other (BIND_SPREAD)
+*/
+void numa_init(const bind_t bind)
+{
+	numa_nodes = 1;
+#ifdef __linux__
+	memset(cpu_node, 0, sizeof(cpu_node));
+	for (int d = 0; d < MAX_NODES; d++)
+	{
+		char name[64], list[4096];
+		sprintf(name, "/sys/devices/system/node/node%d/cpulist", d);
+		FILE *f = fopen(name, "r");
+		if (f == NULL)
+			continue;
+		if (fgets(list, sizeof(list), f) != NULL)
+		{
+			// "0-3,8-11"
+			for (char *p = list; *p >= '0' && *p <= '9'; )
+			{
+				const int a = (int)strtol(p, &p, 10);
+				const int b = (*p == '-') ? (int)strtol(p + 1, &p, 10) : a;
+				for (int c = a; c <= b && c < CPU_SETSIZE; c++)
+					cpu_node[c] = d;
+				if (*p == ',')
+					p++;
+			}
+		}
+		fclose(f);
+		if (d + 1 > numa_nodes)
+			numa_nodes = d + 1;
+	}
+	if (bind == BIND_NONE)
+		return;
+
+	cpu_set_t allowed;
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+		return;
+	int cpus[CPU_SETSIZE];
+	int ncpu = 0;
+	if (bind == BIND_COMPACT)
+	{
+		for (int d = 0; d < numa_nodes; d++)
+			for (int c = 0; c < CPU_SETSIZE; c++)
+				if (CPU_ISSET(c, &allowed) && cpu_node[c] == d)
+					cpus[ncpu++] = c;
+	}
+	else
+	{
+		// round robin over the nodes
+		int next[MAX_NODES] = {0};
+		for (int found = 1; found; )
+		{
+			found = 0;
+			for (int d = 0; d < numa_nodes; d++)
+			{
+				while (next[d] < CPU_SETSIZE && !(CPU_ISSET(next[d], &allowed) && cpu_node[next[d]] == d))
+					next[d]++;
+				if (next[d] < CPU_SETSIZE)
+				{
+					cpus[ncpu++] = next[d]++;
+					found = 1;
+				}
+			}
+		}
+	}
+	if (ncpu == 0)
+		return;
+	#pragma omp parallel
+	{
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpus[omp_get_thread_num() % ncpu], &set);
+		sched_setaffinity(0, sizeof(set), &set);
+	}
+#else
+	(void)bind;
+#endif
+}
+
+/*
+	Huge pages for the tables, they are read from end to end by every main
+	sum and 4 kB pages cost a TLB miss every 256 terms :
+	0 : none, 1 : transparent huge pages (madvise), 2 : explicit huge pages
+	(MAP_HUGETLB, needs vm.nr_hugepages) and transparent ones if there are none
+*/
+#ifndef TABLE_HUGEPAGE
+#define TABLE_HUGEPAGE 1
+#endif
+
+#define HUGEPAGE_SIZE (2u << 20)
+
+// Room for the terms 0..size-1, nothing is touched here (first touch is the fill)
+void table_alloc(table_t *tb, const ui64 size)
+{
+	const size_t stream = (size + 7) & ~(ui64)7;	// 64 bytes multiple
+	tb->bytes = 2*stream*sizeof(double);
+	tb->mem = NULL;
+	tb->mapped = 0;
+#ifdef __linux__
+	if (TABLE_HUGEPAGE)
+		tb->bytes = (tb->bytes + HUGEPAGE_SIZE - 1)/HUGEPAGE_SIZE*HUGEPAGE_SIZE;
+	void *p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+	if (TABLE_HUGEPAGE == 2)
+		p = mmap(NULL, tb->bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+	if (p == MAP_FAILED)
+	{
+		p = mmap(NULL, tb->bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+		if (p != MAP_FAILED && TABLE_HUGEPAGE)
+			madvise(p, tb->bytes, MADV_HUGEPAGE);
+#endif
+	}
+	if (p != MAP_FAILED)
+	{
+		tb->mem = (double *)p;
+		tb->mapped = 1;
+	}
+#endif
+	if (tb->mem == NULL)
+	{
+		void *q = NULL;
+		if (posix_memalign(&q, 64, tb->bytes) != 0)
+		{
+			printf("cannot allocate the tables (%.0lf bytes)\n",(double)tb->bytes);
+			exit(0);
+		}
+		tb->mem = (double *)q;
+	}
+#if TABLE_INTERLEAVED
+	tb->isq = tb->mem;
+	tb->lgi = tb->mem + 1;
+#else
+	tb->isq = tb->mem;
+	tb->lgi = tb->mem + stream;
+#endif
+}
+
+void table_release(table_t *tb)
+{
+#ifdef __linux__
+	if (tb->mapped)
+	{
+		munmap(tb->mem, tb->bytes);
+		return;
+	}
+#endif
+	free(tb->mem);
+}
+
+/*
+	Smallest prime factors for the sieve main sum (-k sieve) : for j >= 2
+	j = sieve_spf[j] * sieve_cof[j], with sieve_spf[p] = p and sieve_cof[p] = 1
+	for a prime p. sieve_primes lists the sieve_nprimes primes in order.
+*/
+int  sieve_wanted = 0;
+int *sieve_spf = NULL;
+int *sieve_cof = NULL;
+int *sieve_primes = NULL;
+int  sieve_nprimes = 0;
+
+/*
+	Term buffers of main_sum_sieve, one per thread. The OpenMP workers
+	never give theirs back, so every buffer is also put on sieve_bufs and
+	free_table releases them all. A thread whose buffer belongs to an
+	older sieve_gen (freed since) makes a new one.
+*/
+typedef struct sieve_buf_s {
+	double *w;	// w_j = w[j] + i w[cap + j]
+	int     cap;
+	struct sieve_buf_s *next;
+} sieve_buf_t;
+
+sieve_buf_t *sieve_bufs = NULL;
+int          sieve_gen = 0;
+
+// Linear sieve below size, every composite is crossed once, by its smallest prime factor
+void compute_sieve(const ui64 size)
+{
+	sieve_spf = (int *)calloc(size, sizeof(int));
+	sieve_cof = (int *)malloc(size*sizeof(int));
+	sieve_primes = (int *)malloc((size/2 + 2)*sizeof(int));
+	sieve_nprimes = 0;
+	for (ui64 i = 2; i < size; i++)
+	{
+		if (sieve_spf[i] == 0)
+		{
+			sieve_spf[i] = (int)i;
+			sieve_cof[i] = 1;
+			sieve_primes[sieve_nprimes++] = (int)i;
+		}
+		for (int k = 0; k < sieve_nprimes; k++)
+		{
+			const ui64 p = sieve_primes[k];
+			if (p > (ui64)sieve_spf[i] || p*i >= size)
+				break;
+			sieve_spf[p*i] = (int)p;
+			sieve_cof[p*i] = (int)i;
+		}
+	}
+}
+
+/*
+	Logarithms in double-double for the precision ladder (-q) :
+	log j = log_int[j] + prec_log_lo[j] to about 2^-104. The primes go
+	through q_log, every other j is log spf + log cof (compute_sieve),
+	one double-double addition.
+*/
+#ifdef __SIZEOF_FLOAT128__
+typedef __float128 f128_t;
+#define F128_NAME "__float128"
+#else
+typedef long double f128_t;	// quad on aarch64
+#define F128_NAME "long double"
+#endif
+
+int     prec_ladder = 0;
+double *prec_log_lo = NULL;
+
+static inline f128_t f128_sum(const double a, const double b, const double c)
+{
+	return ((f128_t)a + (f128_t)b) + (f128_t)c;
+}
+
+// log x, x > 0 : x = 2^k m with m in [sqrt(1/2), sqrt(2)], log m = 2 atanh((m-1)/(m+1))
+f128_t q_log(const f128_t x)
+{
+	int k = (int)floor(log2((double)x));
+	f128_t m = x*(f128_t)ldexp(1.0, -k);
+	if (m > (f128_t)1.4142135623730951)
+	{
+		m *= 0.5;
+		k++;
+	}
+	else if (m < (f128_t)0.7071067811865476)
+	{
+		m *= 2.0;
+		k--;
+	}
+	// |s| < 0.172 : s^(2n+1) < 1e-36 from n = 24 on
+	const f128_t s  = (m - 1)/(m + 1);
+	const f128_t s2 = s*s;
+	f128_t sum = 0, p = s;
+	for (int n = 0; n < 24; n++)
+	{
+		sum += p/(2*n + 1);
+		p *= s2;
+	}
+	return (f128_t)k*f128_sum(6.93147180559945286e-01, 2.31904681384629956e-17, 5.70770843841621207e-34) + 2*sum;
+}
+
+void compute_log_lo(const ui64 size)
+{
+	const double *lgi = table_lgi();
+	free(prec_log_lo);
+	prec_log_lo = (double *)calloc(size, sizeof(double));
+
+	#pragma omp parallel for schedule(dynamic, 64)
+	for (int k = 0; k < sieve_nprimes; k++)
+	{
+		const int p = sieve_primes[k];
+		prec_log_lo[p] = (double)(q_log((f128_t)p) - (f128_t)lgi[TAB_STRIDE*p]);
+	}
+	// the two factors of j are done before j
+	for (ui64 j = 4; j < size; j++)
+	{
+		if (sieve_cof[j] == 1)
+			continue;
+		const int a = sieve_spf[j];
+		const int b = sieve_cof[j];
+		const double ha = lgi[TAB_STRIDE*a];
+		const double hb = lgi[TAB_STRIDE*b];
+		const double s  = ha + hb;
+		const double bb = s - ha;
+		const double e  = (ha - (s - bb)) + (hb - bb);
+		// s and log_int[j] are within an ulp, their difference is exact
+		prec_log_lo[j] = ((s - lgi[TAB_STRIDE*j]) + e) + (prec_log_lo[a] + prec_log_lo[b]);
+	}
+}
+
+void compute_table(ui64 size)
+{
+	if (numa_nodes == 0)
+		numa_init(BIND_NONE);
+	const int nb_thread = omp_get_max_threads();
+	int *node = (int *)malloc(nb_thread*sizeof(int));
+	int copy_of_node[MAX_NODES];
+
+	#pragma omp parallel num_threads(nb_thread)
+	{
+		const int th = omp_get_thread_num();
+		const int nb = omp_get_num_threads();
+		node[th] = TABLE_REPLICATE ? current_node() : 0;
+		#pragma omp barrier
+		#pragma omp single
+		{
+			// copies numbered in order of the first thread of their node
+			for (int d = 0; d < MAX_NODES; d++)
+				copy_of_node[d] = -1;
+			table_copies = 0;
+			for (int u = 0; u < nb; u++)
+				if (copy_of_node[node[u]] < 0)
+					copy_of_node[node[u]] = table_copies++;
+			table_copy = (table_t *)malloc(table_copies*sizeof(table_t));
+			for (int c = 0; c < table_copies; c++)
+				table_alloc(&table_copy[c], size);
+		}
+		// the threads of a node share the fill of its copy
+		const int c = copy_of_node[node[th]];
+		int rank = 0, m = 0;
+		for (int u = 0; u < nb; u++)
+		{
+			if (copy_of_node[node[u]] != c)
+				continue;
+			rank += (u < th);
+			m++;
+		}
+		double *isq = table_copy[c].isq;
+		double *lgi = table_copy[c].lgi;
+		const ui64 k0 = 1 + (size - 1)*rank/m;
+		const ui64 k1 = 1 + (size - 1)*(rank + 1)/m;
+		for (ui64 k = k0; k < k1; k++)
+		{
+			isq[TAB_STRIDE*k] = 1.0/sqrt(k);
+			lgi[TAB_STRIDE*k] = log(k);
+		}
+		if (rank == 0)
+			isq[0] = lgi[0] = 0.0;
+		table_id = c;
+	}
+	free(node);
+	if (sieve_wanted || prec_ladder)
+		compute_sieve(size);
+	if (prec_ladder)
+		compute_log_lo(size);
+}
+
+void free_table(void)
+{
+	for (int c = 0; c < table_copies; c++)
+		table_release(&table_copy[c]);
+	free(table_copy);
+	table_copy = NULL;
+	table_copies = 0;
+	free(sieve_spf);
+	free(sieve_cof);
+	free(sieve_primes);
+	sieve_spf = sieve_cof = sieve_primes = NULL;
+	sieve_nprimes = 0;
+	while (sieve_bufs != NULL)
+	{
+		sieve_buf_t *next = sieve_bufs->next;
+		free(sieve_bufs->w);
+		free(sieve_bufs);
+		sieve_bufs = next;
+	}
+	sieve_gen++;
+	free(prec_log_lo);
+	prec_log_lo = NULL;
+}
+
+/*************************************************************************
+	Main sum kernels : sum_{j=j0}^{j1} j^{-1/2} cos(theta(t) - t log j)
+
+	The phase goes up to t*log(N) (~1e11 at t=1e10), so the cosine is
+	range reduced by k*pi/2 with a 3 parts Cody-Waite split (33 bits each,
+	same as fdlibm), then evaluated by the Cephes sin/cos polynomials on
+	[-pi/4,pi/4]. The quadrant k is read from the low bits of the rounding
+	magic number, so there is no double->int conversion and no branch.
+	The reduction error stays below the rounding error already present
+	in t*log_int[j], so the result is as accurate as the libm version.
+*************************************************************************/
+
+typedef double (*main_sum_t)(const double t, const double tt, const int j0, const int j1);
+
+// Build the loops marked SIMD_CLONES for the widest x86 ISA available at run time
+#ifdef X86_SIMD
+#define SIMD_CLONES __attribute__((target_clones("avx512f","avx2","default")))
+#else
+#define SIMD_CLONES
+#endif
+
+/*
+	Tile kernels : the main sums of TILE_K samples at once, ZZ[k] for t[k], tt[k]=theta(t[k]), Ns[k] terms.
+	The loop over j is outside and the loop over the samples inside, so every
+	invert_sqrt/log_int entry is loaded once per tile instead of once per sample.
+*/
+#ifndef TILE_K
+#define TILE_K 8
+#endif
+
+typedef void (*main_sum_tile_t)(const double *t, const double *tt, const int *Ns, double *ZZ);
+
+static inline int tile_min(const int *Ns)
+{
+	int Nmin = Ns[0];
+	for (int k = 1; k < TILE_K; k++)
+		if (Ns[k] < Nmin)
+			Nmin = Ns[k];
+	return Nmin;
+}
+
+/*
+	Software prefetch TABLE_PREFETCH terms ahead in the vector main sums, once
+	the tables of a sum (16 bytes a term) do not stay in L2. One call covers
+	the 8 terms of a cache line of each stream.
+*/
+#ifndef TABLE_PREFETCH
+#define TABLE_PREFETCH 128
+#endif
+
+#ifndef TABLE_PREFETCH_MIN
+#define TABLE_PREFETCH_MIN 16384
+#endif
+
+static inline __attribute__((always_inline)) void table_prefetch(const double *isq, const double *lgi, const int j)
+{
+#if TABLE_INTERLEAVED
+	__builtin_prefetch(isq + 2*(j + TABLE_PREFETCH));
+	__builtin_prefetch(isq + 2*(j + TABLE_PREFETCH) + 8);
+	(void)lgi;
+#else
+	__builtin_prefetch(isq + j + TABLE_PREFETCH);
+	__builtin_prefetch(lgi + j + TABLE_PREFETCH);
+#endif
+}
+
+static const double two_over_pi = 6.36619772367581382433e-01;
+static const double round_magic = 6755399441055744.0; /* 1.5*2^52 */
+static const double pio2_1      = 1.57079632673412561417e+00;
+static const double pio2_2      = 6.07710050630396597660e-11;
+static const double pio2_3      = 2.02226624871116645580e-21;
+
+static const double sin_c0 =  1.58962301576546568060e-10;
+static const double sin_c1 = -2.50507477628578072866e-08;
+static const double sin_c2 =  2.75573136213857245213e-06;
+static const double sin_c3 = -1.98412698295895385996e-04;
+static const double sin_c4 =  8.33333333332211858878e-03;
+static const double sin_c5 = -1.66666666666666307295e-01;
+
+static const double cos_c0 = -1.13585365213876817300e-11;
+static const double cos_c1 =  2.08757008419747316778e-09;
+static const double cos_c2 = -2.75573141792967388112e-07;
+static const double cos_c3 =  2.48015872888517045348e-05;
+static const double cos_c4 = -1.38888888888730564116e-03;
+static const double cos_c5 =  4.16666666666665929218e-02;
+
+// Branch free scalar cosine, the compiler can vectorize loops calling it
+static inline __attribute__((always_inline)) double rs_cos(const double x)
+{
+	const double ky = x*two_over_pi + round_magic;
+	const double k  = ky - round_magic;
+	uint64_t q;
+	memcpy(&q, &ky, sizeof(q));
+
+	double r = x - k*pio2_1;
+	r = r - k*pio2_2;
+	r = r - k*pio2_3;
+	const double z = r*r;
+
+	const double s = r + r*z*(((((sin_c0*z + sin_c1)*z + sin_c2)*z + sin_c3)*z + sin_c4)*z + sin_c5);
+	const double c = 1.0 - 0.5*z + z*z*(((((cos_c0*z + cos_c1)*z + cos_c2)*z + cos_c3)*z + cos_c4)*z + cos_c5);
+
+	// quadrant 0 : cos, 1 : -sin, 2 : -cos, 3 : sin
+	double v = (q & 1) ? s : c;
+	uint64_t vb;
+	memcpy(&vb, &v, sizeof(vb));
+	vb ^= ((q + 1) & 2) << 62;
+	memcpy(&v, &vb, sizeof(v));
+	return v;
+}
+
+// Same reduction, returns both sin(x) and cos(x)
+static inline __attribute__((always_inline)) void rs_sincos(const double x, double *sin_x, double *cos_x)
+{
+	const double ky = x*two_over_pi + round_magic;
+	const double k  = ky - round_magic;
+	uint64_t q;
+	memcpy(&q, &ky, sizeof(q));
+
+	double r = x - k*pio2_1;
+	r = r - k*pio2_2;
+	r = r - k*pio2_3;
+	const double z = r*r;
+
+	const double s = r + r*z*(((((sin_c0*z + sin_c1)*z + sin_c2)*z + sin_c3)*z + sin_c4)*z + sin_c5);
+	const double c = 1.0 - 0.5*z + z*z*(((((cos_c0*z + cos_c1)*z + cos_c2)*z + cos_c3)*z + cos_c4)*z + cos_c5);
+
+	// quadrant 0 : (s,c), 1 : (c,-s), 2 : (-s,-c), 3 : (-c,s)
+	double vs = (q & 1) ? c : s;
+	double vc = (q & 1) ? s : c;
+	uint64_t bs, bc;
+	memcpy(&bs, &vs, sizeof(bs));
+	memcpy(&bc, &vc, sizeof(bc));
+	bs ^= (q & 2) << 62;
+	bc ^= ((q + 1) & 2) << 62;
+	memcpy(sin_x, &bs, sizeof(bs));
+	memcpy(cos_x, &bc, sizeof(bc));
+}
+
+// Reference kernel, libm cos (vectorized by armpl on ARM)
+double main_sum_scalar(const double t, const double tt, const int j0, const int j1)
+{
+	const double *isq = table_isq();
+	const double *lgi = table_lgi();
+	double ZZ = 0.0;
+	for (int j=j0;j <= j1;j++) {
+		ZZ = ZZ + isq[TAB_STRIDE*j] * cos(tt - t*lgi[TAB_STRIDE*j]);
+	}
+	return ZZ;
+}
+
+// Same loop with the in-house cosine, left to the auto-vectorizer
+double main_sum_portable(const double t, const double tt, const int j0, const int j1)
+{
+	const double *isq = table_isq();
+	const double *lgi = table_lgi();
+	double ZZ = 0.0;
+	for (int j=j0;j <= j1;j++) {
+		ZZ = ZZ + isq[TAB_STRIDE*j] * rs_cos(tt - t*lgi[TAB_STRIDE*j]);
+	}
+	return ZZ;
+}
+
+void main_sum_tile_scalar(const double *t, const double *tt, const int *Ns, double *ZZ)
+{
+	const double *isq = table_isq();
+	const double *lgi = table_lgi();
+	const int Nmin = tile_min(Ns);
+	double acc[TILE_K];
+	for (int k = 0; k < TILE_K; k++)
+		acc[k] = 0.0;
+	for (int j=1;j <= Nmin;j++) {
+		const double a = isq[TAB_STRIDE*j];
+		const double l = lgi[TAB_STRIDE*j];
+		for (int k = 0; k < TILE_K; k++)
+			acc[k] += a * cos(tt[k] - t[k]*l);
+	}
+	for (int k = 0; k < TILE_K; k++) {
+		for (int j=Nmin+1;j <= Ns[k];j++)
+			acc[k] += isq[TAB_STRIDE*j] * cos(tt[k] - t[k]*lgi[TAB_STRIDE*j]);
+		ZZ[k] = acc[k];
+	}
+}
+
+// Terms Nmin < j <= Ns[k] left by the vector loops
+static inline void tile_tail(const double *t, const double *tt, const int *Ns, const int j0, double *acc)
+{
+	const double *isq = table_isq();
+	const double *lgi = table_lgi();
+	for (int k = 0; k < TILE_K; k++)
+		for (int j=j0;j <= Ns[k];j++)
+			acc[k] += isq[TAB_STRIDE*j] * rs_cos(tt[k] - t[k]*lgi[TAB_STRIDE*j]);
+}
+
+void main_sum_tile_portable(const double *t, const double *tt, const int *Ns, double *ZZ)
+{
+	const double *isq = table_isq();
+	const double *lgi = table_lgi();
+	const int Nmin = tile_min(Ns);
+	double acc[TILE_K];
+	for (int k = 0; k < TILE_K; k++)
+		acc[k] = 0.0;
+	for (int j=1;j <= Nmin;j++) {
+		const double a = isq[TAB_STRIDE*j];
+		const double l = lgi[TAB_STRIDE*j];
+		for (int k = 0; k < TILE_K; k++)
+			acc[k] += a * rs_cos(tt[k] - t[k]*l);
+	}
+	tile_tail(t, tt, Ns, Nmin+1, acc);
+	for (int k = 0; k < TILE_K; k++)
+		ZZ[k] = acc[k];
+}
+
+#ifdef X86_SIMD
+static inline __m128d cos_sse2(const __m128d x)
+{
+	const __m128d ky = _mm_add_pd(_mm_mul_pd(x, _mm_set1_pd(two_over_pi)), _mm_set1_pd(round_magic));
+	const __m128d k  = _mm_sub_pd(ky, _mm_set1_pd(round_magic));
+	const __m128i q  = _mm_castpd_si128(ky);
+
+	__m128d r = _mm_sub_pd(x, _mm_mul_pd(k, _mm_set1_pd(pio2_1)));
+	r = _mm_sub_pd(r, _mm_mul_pd(k, _mm_set1_pd(pio2_2)));
+	r = _mm_sub_pd(r, _mm_mul_pd(k, _mm_set1_pd(pio2_3)));
+	const __m128d z = _mm_mul_pd(r, r);
+
+	__m128d ps = _mm_set1_pd(sin_c0);
+	ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(sin_c1));
+	ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(sin_c2));
+	ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(sin_c3));
+	ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(sin_c4));
+	ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(sin_c5));
+	const __m128d s = _mm_add_pd(r, _mm_mul_pd(_mm_mul_pd(r, z), ps));
+
+	__m128d pc = _mm_set1_pd(cos_c0);
+	pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(cos_c1));
+	pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(cos_c2));
+	pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(cos_c3));
+	pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(cos_c4));
+	pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(cos_c5));
+	const __m128d c = _mm_add_pd(_mm_sub_pd(_mm_set1_pd(1.0), _mm_mul_pd(_mm_set1_pd(0.5), z)), _mm_mul_pd(_mm_mul_pd(z, z), pc));
+
+	const __m128i one  = _mm_set1_epi64x(1);
+	const __m128d odd  = _mm_castsi128_pd(_mm_sub_epi64(_mm_setzero_si128(), _mm_and_si128(q, one)));
+	const __m128d sign = _mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(_mm_add_epi64(q, one), _mm_set1_epi64x(2)), 62));
+	const __m128d v    = _mm_or_pd(_mm_and_pd(odd, s), _mm_andnot_pd(odd, c));
+	return _mm_xor_pd(v, sign);
+}
+
+// Terms j, j+1 : a = 1/sqrt(j), l = log(j) in the same lanes (pairs are split by unpack)
+static inline void terms_sse2(const double *isq, const double *lgi, const int j, __m128d *a, __m128d *l)
+{
+#if TABLE_INTERLEAVED
+	const __m128d p0 = _mm_loadu_pd(isq + 2*j);
+	const __m128d p1 = _mm_loadu_pd(isq + 2*j + 2);
+	*a = _mm_unpacklo_pd(p0, p1);
+	*l = _mm_unpackhi_pd(p0, p1);
+	(void)lgi;
+#else
+	*a = _mm_loadu_pd(isq + j);
+	*l = _mm_loadu_pd(lgi + j);
+#endif
+}
+
+double main_sum_sse2(const double t, const double tt, const int j0, const int j1)
+{
+	const double *isq = table_isq();
+	const double *lgi = table_lgi();
+	const __m128d vt  = _mm_set1_pd(t);
+	const __m128d vtt = _mm_set1_pd(tt);
+	const int pf = (j1 - j0 >= TABLE_PREFETCH_MIN);
+	__m128d acc = _mm_setzero_pd();
+	int j = j0;
+	for (; j+1 <= j1; j += 2) {
+		if (pf && !(j & 6))
+			table_prefetch(isq, lgi, j);
+		__m128d a, l;
+		terms_sse2(isq, lgi, j, &a, &l);
+		const __m128d x = _mm_sub_pd(vtt, _mm_mul_pd(vt, l));
+		acc = _mm_add_pd(acc, _mm_mul_pd(a, cos_sse2(x)));
+	}
+	double lanes[2];
+	_mm_storeu_pd(lanes, acc);
+	double ZZ = lanes[0] + lanes[1];
+	for (; j <= j1; j++) {
+		ZZ = ZZ + isq[TAB_STRIDE*j] * rs_cos(tt - t*lgi[TAB_STRIDE*j]);
+	}
+	return ZZ;
+}
+
+void main_sum_tile_sse2(const double *t, const double *tt, const int *Ns, double *ZZ)
+{
+	const double *isq = table_isq();
+	const double *lgi = table_lgi();
+	const int Nmin = tile_min(Ns);
+	__m128d acc[TILE_K];
+	for (int k = 0; k < TILE_K; k++)
+		acc[k] = _mm_setzero_pd();
+	int j = 1;
+	for (; j+1 <= Nmin; j += 2) {
+		__m128d a, l;
+		terms_sse2(isq, lgi, j, &a, &l);
+		for (int k = 0; k < TILE_K; k++) {
+			const __m128d x = _mm_sub_pd(_mm_set1_pd(tt[k]), _mm_mul_pd(_mm_set1_pd(t[k]), l));
+			acc[k] = _mm_add_pd(acc[k], _mm_mul_pd(a, cos_sse2(x)));
+		}
+	}
+	double sum[TILE_K];
+	for (int k = 0; k < TILE_K; k++) {
+		double lanes[2];
+		_mm_storeu_pd(lanes, acc[k]);
+		sum[k] = lanes[0] + lanes[1];
+	}
+	tile_tail(t, tt, Ns, j, sum);
+	for (int k = 0; k < TILE_K; k++)
+		ZZ[k] = sum[k];
+}
+
+static inline __attribute__((target("avx2,fma"))) __m256d cos_avx2(const __m256d x)
+{
+	const __m256d ky = _mm256_fmadd_pd(x, _mm256_set1_pd(two_over_pi), _mm256_set1_pd(round_magic));
+	const __m256d k  = _mm256_sub_pd(ky, _mm256_set1_pd(round_magic));
+	const __m256i q  = _mm256_castpd_si256(ky);
+
+	__m256d r = _mm256_fnmadd_pd(k, _mm256_set1_pd(pio2_1), x);
+	r = _mm256_fnmadd_pd(k, _mm256_set1_pd(pio2_2), r);
+	r = _mm256_fnmadd_pd(k, _mm256_set1_pd(pio2_3), r);
+	const __m256d z = _mm256_mul_pd(r, r);
+
+	__m256d ps = _mm256_set1_pd(sin_c0);
+	ps = _mm256_fmadd_pd(ps, z, _mm256_set1_pd(sin_c1));
+	ps = _mm256_fmadd_pd(ps, z, _mm256_set1_pd(sin_c2));
+	ps = _mm256_fmadd_pd(ps, z, _mm256_set1_pd(sin_c3));
+	ps = _mm256_fmadd_pd(ps, z, _mm256_set1_pd(sin_c4));
+	ps = _mm256_fmadd_pd(ps, z, _mm256_set1_pd(sin_c5));
+	const __m256d s = _mm256_fmadd_pd(_mm256_mul_pd(r, z), ps, r);
+
+	__m256d pc = _mm256_set1_pd(cos_c0);
+	pc = _mm256_fmadd_pd(pc, z, _mm256_set1_pd(cos_c1));
+	pc = _mm256_fmadd_pd(pc, z, _mm256_set1_pd(cos_c2));
+	pc = _mm256_fmadd_pd(pc, z, _mm256_set1_pd(cos_c3));
+	pc = _mm256_fmadd_pd(pc, z, _mm256_set1_pd(cos_c4));
+	pc = _mm256_fmadd_pd(pc, z, _mm256_set1_pd(cos_c5));
+	const __m256d c = _mm256_fmadd_pd(_mm256_mul_pd(z, z), pc, _mm256_fnmadd_pd(_mm256_set1_pd(0.5), z, _mm256_set1_pd(1.0)));
+
+	const __m256i one  = _mm256_set1_epi64x(1);
+	const __m256d odd  = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(q, one), one));
+	const __m256d sign = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(_mm256_add_epi64(q, one), _mm256_set1_epi64x(2)), 62));
+	return _mm256_xor_pd(_mm256_blendv_pd(c, s, odd), sign);
+}
+
+static inline __attribute__((target("avx2,fma"))) void terms_avx2(const double *isq, const double *lgi, const int j, __m256d *a, __m256d *l)
+{
+#if TABLE_INTERLEAVED
+	const __m256d p0 = _mm256_loadu_pd(isq + 2*j);
+	const __m256d p1 = _mm256_loadu_pd(isq + 2*j + 4);
+	*a = _mm256_unpacklo_pd(p0, p1);
+	*l = _mm256_unpackhi_pd(p0, p1);
+	(void)lgi;
+#else
+	*a = _mm256_loadu_pd(isq + j);
+	*l = _mm256_loadu_pd(lgi + j);
+#endif
+}
+
+__attribute__((target("avx2,fma"))) double main_sum_avx2(const double t, const double tt, const int j0, const int j1)
+{
+	const double *isq = table_isq();
+	const double *lgi = table_lgi();
+	const __m256d vt  = _mm256_set1_pd(t);
+	const __m256d vtt = _mm256_set1_pd(tt);
+	const int pf = (j1 - j0 >= TABLE_PREFETCH_MIN);
+	__m256d acc = _mm256_setzero_pd();
+	int j = j0;
+	for (; j+3 <= j1; j += 4) {
+		if (pf && !(j & 4))
+			table_prefetch(isq, lgi, j);
+		__m256d a, l;
+		terms_avx2(isq, lgi, j, &a, &l);
+		const __m256d x = _mm256_fnmadd_pd(vt, l, vtt);
+		acc = _mm256_fmadd_pd(a, cos_avx2(x), acc);
+	}
+	double lanes[4];
+	_mm256_storeu_pd(lanes, acc);
+	double ZZ = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	for (; j <= j1; j++) {
+		ZZ = ZZ + isq[TAB_STRIDE*j] * rs_cos(tt - t*lgi[TAB_STRIDE*j]);
+	}
+	return ZZ;
+}
+
+__attribute__((target("avx2,fma"))) void main_sum_tile_avx2(const double *t, const double *tt, const int *Ns, double *ZZ)
+{
+	const double *isq = table_isq();
+	const double *lgi = table_lgi();
+	const int Nmin = tile_min(Ns);
+	__m256d acc[TILE_K];
+	for (int k = 0; k < TILE_K; k++)
+		acc[k] = _mm256_setzero_pd();
+	int j = 1;
+	for (; j+3 <= Nmin; j += 4) {
+		__m256d a, l;
+		terms_avx2(isq, lgi, j, &a, &l);
+		for (int k = 0; k < TILE_K; k++) {
+			const __m256d x = _mm256_fnmadd_pd(_mm256_set1_pd(t[k]), l, _mm256_set1_pd(tt[k]));
+			acc[k] = _mm256_fmadd_pd(a, cos_avx2(x), acc[k]);
+		}
+	}
+	double sum[TILE_K];
+	for (int k = 0; k < TILE_K; k++) {
+		double lanes[4];
+		_mm256_storeu_pd(lanes, acc[k]);
+		sum[k] = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	}
+	tile_tail(t, tt, Ns, j, sum);
+	for (int k = 0; k < TILE_K; k++)
+		ZZ[k] = sum[k];
+}
+
+static inline __attribute__((target("avx512f"))) __m512d cos_avx512(const __m512d x)
+{
+	const __m512d ky = _mm512_fmadd_pd(x, _mm512_set1_pd(two_over_pi), _mm512_set1_pd(round_magic));
+	const __m512d k  = _mm512_sub_pd(ky, _mm512_set1_pd(round_magic));
+	const __m512i q  = _mm512_castpd_si512(ky);
+
+	__m512d r = _mm512_fnmadd_pd(k, _mm512_set1_pd(pio2_1), x);
+	r = _mm512_fnmadd_pd(k, _mm512_set1_pd(pio2_2), r);
+	r = _mm512_fnmadd_pd(k, _mm512_set1_pd(pio2_3), r);
+	const __m512d z = _mm512_mul_pd(r, r);
+
+	__m512d ps = _mm512_set1_pd(sin_c0);
+	ps = _mm512_fmadd_pd(ps, z, _mm512_set1_pd(sin_c1));
+	ps = _mm512_fmadd_pd(ps, z, _mm512_set1_pd(sin_c2));
+	ps = _mm512_fmadd_pd(ps, z, _mm512_set1_pd(sin_c3));
+	ps = _mm512_fmadd_pd(ps, z, _mm512_set1_pd(sin_c4));
+	ps = _mm512_fmadd_pd(ps, z, _mm512_set1_pd(sin_c5));
+	const __m512d s = _mm512_fmadd_pd(_mm512_mul_pd(r, z), ps, r);
+
+	__m512d pc = _mm512_set1_pd(cos_c0);
+	pc = _mm512_fmadd_pd(pc, z, _mm512_set1_pd(cos_c1));
+	pc = _mm512_fmadd_pd(pc, z, _mm512_set1_pd(cos_c2));
+	pc = _mm512_fmadd_pd(pc, z, _mm512_set1_pd(cos_c3));
+	pc = _mm512_fmadd_pd(pc, z, _mm512_set1_pd(cos_c4));
+	pc = _mm512_fmadd_pd(pc, z, _mm512_set1_pd(cos_c5));
+	const __m512d c = _mm512_fmadd_pd(_mm512_mul_pd(z, z), pc, _mm512_fnmadd_pd(_mm512_set1_pd(0.5), z, _mm512_set1_pd(1.0)));
+
+	const __m512i one  = _mm512_set1_epi64(1);
+	const __mmask8 odd = _mm512_test_epi64_mask(q, one);
+	const __mmask8 neg = _mm512_test_epi64_mask(_mm512_add_epi64(q, one), _mm512_set1_epi64(2));
+	const __m512i v    = _mm512_castpd_si512(_mm512_mask_blend_pd(odd, c, s));
+	return _mm512_castsi512_pd(_mm512_mask_xor_epi64(v, neg, v, _mm512_set1_epi64((long long)0x8000000000000000ULL)));
+}
+
+// cnt <= 8 terms from j, the lanes past cnt get a = l = 0
+static inline __attribute__((target("avx512f"))) void terms_avx512(const double *isq, const double *lgi, const int j, const int cnt,
+		__m512d *a, __m512d *l)
+{
+#if TABLE_INTERLEAVED
+	const __mmask8 m0 = (__mmask8)((cnt >= 4) ? 0xFFu : (1u << 2*cnt) - 1u);
+	const __mmask8 m1 = (__mmask8)((cnt > 4) ? (1u << 2*(cnt - 4)) - 1u : 0u);
+	const __m512d p0 = _mm512_maskz_loadu_pd(m0, isq + 2*j);
+	const __m512d p1 = _mm512_maskz_loadu_pd(m1, isq + 2*j + 8);
+	*a = _mm512_permutex2var_pd(p0, _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0), p1);
+	*l = _mm512_permutex2var_pd(p0, _mm512_set_epi64(15, 13, 11, 9, 7, 5, 3, 1), p1);
+	(void)lgi;
+#else
+	const __mmask8 m = (__mmask8)((cnt >= 8) ? 0xFFu : (1u << cnt) - 1u);
+	*a = _mm512_maskz_loadu_pd(m, isq + j);
+	*l = _mm512_maskz_loadu_pd(m, lgi + j);
+#endif
+}
+
+__attribute__((target("avx512f"))) double main_sum_avx512(const double t, const double tt, const int j0, const int j1)
+{
+	const double *isq = table_isq();
+	const double *lgi = table_lgi();
+	const __m512d vt  = _mm512_set1_pd(t);
+	const __m512d vtt = _mm512_set1_pd(tt);
+	const int pf = (j1 - j0 >= TABLE_PREFETCH_MIN);
+	__m512d acc = _mm512_setzero_pd();
+	int j = j0;
+	for (; j+7 <= j1; j += 8) {
+		if (pf)
+			table_prefetch(isq, lgi, j);
+		__m512d a, l;
+		terms_avx512(isq, lgi, j, 8, &a, &l);
+		const __m512d x = _mm512_fnmadd_pd(vt, l, vtt);
+		acc = _mm512_fmadd_pd(a, cos_avx512(x), acc);
+	}
+	// masked tail, keeps the whole sum in the vector kernel (a = 0 in the lanes past j1)
+	if (j <= j1) {
+		__m512d a, l;
+		terms_avx512(isq, lgi, j, j1 - j + 1, &a, &l);
+		const __m512d x = _mm512_fnmadd_pd(vt, l, vtt);
+		acc = _mm512_fmadd_pd(a, cos_avx512(x), acc);
+	}
+	double lanes[8];
+	_mm512_storeu_pd(lanes, acc);
+	return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+}
+
+__attribute__((target("avx512f"))) void main_sum_tile_avx512(const double *t, const double *tt, const int *Ns, double *ZZ)
+{
+	const double *isq = table_isq();
+	const double *lgi = table_lgi();
+	const int Nmin = tile_min(Ns);
+	__m512d acc[TILE_K];
+	for (int k = 0; k < TILE_K; k++)
+		acc[k] = _mm512_setzero_pd();
+	int j = 1;
+	for (; j+7 <= Nmin; j += 8) {
+		__m512d a, l;
+		terms_avx512(isq, lgi, j, 8, &a, &l);
+		for (int k = 0; k < TILE_K; k++) {
+			const __m512d x = _mm512_fnmadd_pd(_mm512_set1_pd(t[k]), l, _mm512_set1_pd(tt[k]));
+			acc[k] = _mm512_fmadd_pd(a, cos_avx512(x), acc[k]);
+		}
+	}
+	double sum[TILE_K];
+	for (int k = 0; k < TILE_K; k++) {
+		double lanes[8];
+		_mm512_storeu_pd(lanes, acc[k]);
+		sum[k] = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+	}
+	tile_tail(t, tt, Ns, j, sum);
+	for (int k = 0; k < TILE_K; k++)
+		ZZ[k] = sum[k];
+}
+#endif
+
+/*
+	Coefficients C0..C4 of the remainder, z = 2p-1 in [-1,1]
+
+	C0, C2, C4 are even and C1, C3 odd in z, so they are tabulated on
+	w = |z| only : CHEB_SEG segments of width 1/CHEB_SEG, on each one a
+	polynomial of degree CHEB_DEG in u = w - (middle of the segment),
+	interpolated at the Chebyshev nodes of the segment (mpmath, 50
+	digits) from Gabcke's expansions of C0..C4 (the degree 40 series the
+	code used before). The polynomials are within 5.4e-17 of the series,
+	evaluated in double the gap is at most (1e-16, by segment of |z|) :
+	  C0  1.2 1.1 1.2 1.1 2.1 2.5 2.2 2.4
+	  C1  .01 .02 .03 .04 .03 .03 .03 .09
+	  C2  .02 .02 .02 .02 .02 .01 .01 .004
+	  C3, C4 below .002
+	2 ulp of C0 at most, the rounding of the evaluation. paw_t holds the
+	segment, u, u^2, u^4, u^8 and the sign of z, the five coefficients
+	share these powers in their Estrin schemes
+	(depth 4 instead of the CHEB_DEG steps of Horner) on a 3.8 KB table,
+	rs_cheb[k][power of u][segment].
+*/
+#define CHEB_SEG 8
+#define CHEB_DEG 11
+
+static const double rs_cheb[5][CHEB_DEG+1][CHEB_SEG] = {
+	{	// C0, u^0 .. u^11
+		{3.84393422035676502e-01, 3.98218168001306827e-01, 4.26631219433968978e-01, 4.71109768784607086e-01, 5.33709887789547865e-01, 6.16772996367327520e-01, 7.22355297772835248e-01, 8.51218805652489752e-01},
+		{5.47842542560163584e-02, 1.67435767388996321e-01, 2.89159224784966695e-01, 4.25275883119396181e-01, 5.79520858947392470e-01, 7.52361346807655984e-01, 9.38185752711763521e-01, 1.12106635619623196e+00},
+		{4.40339907461594626e-01, 4.64894804958289609e-01, 5.12498384813747543e-01, 5.79033458146260727e-01, 6.55421997215257068e-01, 7.23842793276179730e-01, 7.52516728235426147e-01, 6.89706780058518154e-01},
+		{3.30269877647423049e-02, 9.73111566242596815e-02, 1.54847758986308121e-01, 1.96138923409283655e-01, 2.03581149498074876e-01, 1.47484287639736811e-01, -1.73133250184926285e-02, -3.51635578716400166e-01},
+		{1.31564893911789105e-01, 1.24013628145754923e-01, 1.03086488668705886e-01, 5.63471733879083447e-02, -3.63505232215743518e-02, -2.03060929561349801e-01, -4.76634113346014132e-01, -8.84224898094237433e-01},
+		{-5.28776894405177077e-03, -2.04068766884446702e-02, -4.98427320190550499e-02, -1.05081280010057523e-01, -1.99100057687519760e-01, -3.43390705883055813e-01, -5.39887438655729968e-01, -7.64974176700659148e-01},
+		{-1.50941712282212388e-02, -2.73698039491384708e-02, -5.36785214405536074e-02, -9.65668111062276957e-02, -1.56873240867529712e-01, -2.28679791701538043e-01, -2.90638870372499969e-01, -2.93735172477748552e-01},
+		{-6.83115567245665568e-03, -2.15790816186100312e-02, -3.90848022599020323e-02, -5.91980665631001504e-02, -7.76822099305684022e-02, -8.26221366613479474e-02, -4.99214184881050585e-02, 5.96798409079077469e-02},
+		{-1.38508013347478347e-02, -1.59443262591268363e-02, -1.90787550192856488e-02, -2.05021788340084450e-02, -1.45604868900033619e-02, 8.63273783793578643e-03, 6.33643964317357616e-02, 1.64471653227499626e-01},
+		{-9.98725208310841670e-04, -2.57683385858198171e-03, -2.60632514505056796e-03, 8.91296587931703836e-04, 1.11280499038730902e-02, 3.22674668904083528e-02, 6.74057442653668987e-02, 1.13136285880681059e-01},
+		{-1.54210878720915240e-03, -8.29664611775369977e-04, 1.05832299537393865e-03, 4.99713486804498168e-03, 1.19981838939314401e-02, 2.23345324852822699e-02, 3.35400164307556800e-02, 3.69423140962939558e-02},
+		{2.30666031838397075e-04, 8.61487016612608072e-04, 1.99235458008744076e-03, 3.86773909717950514e-03, 6.37174497052418742e-03, 8.41007991116586411e-03, 6.90417069545276249e-03, -4.20409673124655901e-03},
+	},
+	{	// C1, u^0 .. u^11
+		{-1.67316674623234872e-03, -4.92984078538745429e-03, -7.84467911242809138e-03, -9.93651393908122696e-03, -1.03135415172063323e-02, -7.47164129615257230e-03, 8.77103291829080169e-04, 1.78140665231520390e-02},
+		{-2.66606215538484556e-02, -2.51304151830279258e-02, -2.08896900989105141e-02, -1.14183246051550186e-02, 7.36615607762309242e-03, 4.11487474693256888e-02, 9.65862650571334275e-02, 1.79181426562108309e-01},
+		{2.67881504118923450e-03, 1.03382445025721990e-02, 2.52506230206772514e-02, 5.32347983463408447e-02, 1.00865267540792294e-01, 1.73963763859310838e-01, 2.73510171591328621e-01, 3.87540445196030925e-01},
+		{1.52935929839056340e-02, 2.77314093801792165e-02, 5.43877133894370979e-02, 9.78426361779629050e-02, 1.58945824646991085e-01, 2.31701071773827566e-01, 2.94478743232621687e-01, 2.97615952212112400e-01},
+		{1.21124636344866910e-02, 3.82623166397792897e-02, 6.93020725379238367e-02, 1.04965318089807386e-01, 1.37739935493828181e-01, 1.46499021678168806e-01, 8.85167004709196265e-02, -1.05819563492659030e-01},
+		{3.92945807583175641e-02, 4.52338636347698331e-02, 5.41261531599861595e-02, 5.81643202778774973e-02, 4.13077499042279611e-02, -2.44911163549674238e-02, -1.79763869718910285e-01, -4.66603133088534905e-01},
+		{4.25004960611646745e-03, 1.09656445729368751e-02, 1.10911205991999131e-02, -3.79296674017249973e-03, -4.73552744721858695e-02, -1.37313577839268064e-01, -2.86843610600960697e-01, -4.81448658247015715e-01},
+		{9.39811368875201857e-03, 5.08305313250724793e-03, -6.36362796904480030e-03, -3.02714160601047604e-02, -7.28174817522351525e-02, -1.35729564031165983e-01, -2.04136697605858314e-01, -2.25469029982019009e-01},
+		{-1.92132303573405976e-03, -7.18087213090455069e-03, -1.66231316712659345e-02, -3.23021238023583346e-02, -5.32736279387194048e-02, -7.04319088409695870e-02, -5.80876851161494581e-02, 3.44078546342475311e-02},
+		{-3.62558578285600416e-03, -6.14163659745188203e-03, -1.09798731609110026e-02, -1.68287053886377290e-02, -1.92347038763086876e-02, -7.61059091149026389e-03, 3.70613173742255012e-02, 1.38538462675142637e-01},
+		{-1.00783241551352870e-03, -3.00205515485652864e-03, -4.57911048184565447e-03, -4.18692801112782731e-03, 1.80563419735850755e-03, 1.95301207712414576e-02, 5.55712387328272453e-02, 1.08595014349161467e-01},
+		{-1.46742937495910166e-03, -1.39536978136144802e-03, -7.24416084738990318e-04, 1.72209602836190744e-03, 7.74771920948451407e-03, 1.89151734584231679e-02, 3.35786724101619291e-02, 4.05154956913818462e-02},
+	},
+	{	// C2, u^0 .. u^11
+		{5.18957884280241317e-03, 5.18551668282596096e-03, 5.11321099645990415e-03, 4.85516149142744234e-03, 4.27487179582420815e-03, 3.29851936238420183e-03, 2.07150199647477629e-03, 1.19653827796615099e-03},
+		{2.76259074033310941e-05, -1.79402621801270305e-04, -1.13825868409692024e-03, -3.18282481596801657e-03, -6.22081716120370665e-03, -9.23972330685060746e-03, -9.62644433278946922e-03, -2.63878646674113029e-03},
+		{4.42994997874441343e-05, -2.03396581684739050e-03, -5.87668097336624829e-03, -1.04513227138688103e-02, -1.32256838139069698e-02, -9.22710805652031049e-03, 9.31487074375409937e-03, 5.09989193789440395e-02},
+		{-2.82280404363444929e-03, -8.13982155507269982e-03, -1.19314830444930027e-02, -1.13871600510280137e-02, -1.22585428123673157e-03, 2.60729307025855915e-02, 7.69391283244195284e-02, 1.47019628114091333e-01},
+		{-1.11995437091241320e-02, -9.70607263725211007e-03, -4.55595591216865700e-03, 8.49194327755782401e-03, 3.47547506908665871e-02, 7.68884999285629617e-02, 1.25764738888808847e-01, 1.44088911305180783e-01},
+		{9.08520853508486552e-04, 4.44668364223032436e-03, 1.31844810673589358e-02, 3.00754642257021060e-02, 5.49070565548039694e-02, 7.79318998433007754e-02, 6.91189985388309530e-02, -3.29342551795771751e-02},
+		{2.80249753647057167e-03, 7.41357824166362020e-03, 1.65965223526566251e-02, 2.85364905018246282e-02, 3.57628322932676754e-02, 1.92545944203549382e-02, -5.63862659002130825e-02, -2.36447523654996994e-01},
+		{2.60794882800825020e-03, 7.95578436872585761e-03, 1.27613412700847105e-02, 1.32256871952645110e-02, -2.13970187205867547e-04, -4.43264226858433794e-02, -1.37851836230905050e-01, -2.78618820055000049e-01},
+		{5.25265436137558120e-03, 5.36634899974888172e-03, 3.65876322936629483e-03, -4.28768026016203806e-03, -2.54471066941236515e-02, -6.62459452928099018e-02, -1.21328227908722705e-01, -1.48905503184699362e-01},
+		{1.83058030825172569e-04, -2.57599049772553332e-04, -3.42608270225756070e-03, -1.17692615825030315e-02, -2.69518906196167113e-02, -4.51508531294049290e-02, -4.71521334611557791e-02, 1.44710796484758160e-02},
+		{1.82701320668530830e-04, -1.15652082906833251e-03, -4.27530304731772726e-03, -9.36900424487514816e-03, -1.45116566525275489e-02, -1.20652506136116177e-02, 1.55422336720400008e-02, 9.44142973459406454e-02},
+		{-4.53315045474679014e-04, -1.55478183827619052e-03, -3.02648015012987708e-03, -4.19589794562589668e-03, -2.42862707869474347e-03, 8.08440520232333280e-03, 3.54336617027085007e-02, 8.14879474352922240e-02},
+	},
+	{	// C3, u^0 .. u^11
+		{-8.28194177620318850e-05, -2.26842130765272574e-04, -3.08992116763147937e-04, -3.00231716191729273e-04, -1.96095374169962130e-04, -3.16646862845026091e-05, 1.17966667659545829e-04, 1.84807357191483389e-04},
+		{-1.29594100800973838e-03, -9.53715101459635234e-04, -3.20142644118160812e-04, 4.68546189300634761e-04, 1.15157179815584491e-03, 1.37379716639783492e-03, 9.12088052787395033e-04, 2.23071690822944076e-04},
+		{6.98747249338163502e-04, 2.00769348651949099e-03, 2.97335690482451818e-03, 3.16155066993476907e-03, 2.05230566553816097e-03, -4.59905070824338780e-04, -2.98738835241105401e-03, -1.28397491926897172e-03},
+		{3.69104450810705566e-03, 3.18215923560522754e-03, 1.77232938360148977e-03, -1.02045879966748427e-03, -4.99125244490220259e-03, -7.86018961523412933e-03, -3.75826962795229114e-03, 1.62010791481944118e-02},
+		{-4.34967096466310009e-04, -1.74036985237491053e-03, -4.08444124487632350e-03, -7.06605707025727107e-03, -8.11696492130022963e-03, -1.40777157697750911e-03, 2.09977566445386371e-02, 6.09308212862871984e-02},
+		{-1.51430458480313621e-03, -2.84231429319321350e-03, -4.58400336796927887e-03, -4.30895802675125474e-03, 2.51280329266326046e-03, 2.12639230533984980e-02, 5.14838217826906752e-02, 7.04343704135523829e-02},
+		{-9.71295384863240510e-04, -2.38188118062286928e-03, -1.74077595907032247e-03, 3.49689440869373810e-03, 1.60227779106932207e-02, 3.42399149251091869e-02, 4.18987436358560922e-02, -6.39419713350317803e-03},
+		{-2.12817447670531502e-03, -8.20080560288948641e-04, 2.78105706470785710e-03, 9.77978506317534260e-03, 1.87439794327155518e-02, 2.01139172972804071e-02, -1.10978762463598939e-02, -1.14681123339756053e-01},
+		{5.61192182582968780e-04, 2.23120995932745304e-03, 5.19591941031283342e-03, 8.65676681344481821e-03, 7.81929508768158636e-03, -9.19359592059129996e-03, -6.03306962832904706e-02, -1.51904012791235915e-01},
+		{1.08285307871005924e-03, 2.01256280039484184e-03, 3.17634739285661263e-03, 2.32005724590975734e-03, -5.55732180573805315e-03, -2.75624910966789094e-02, -6.50457695896497073e-02, -9.05377905706148400e-02},
+		{4.04861912263778094e-04, 9.95723545557128126e-04, 5.64477036548719424e-04, -2.64549797144144304e-03, -1.10575983059970472e-02, -2.46401504594856817e-02, -3.19848221230745675e-02, 4.24641841343259899e-03},
+		{5.67190461557973450e-04, 2.04037256098232774e-04, -1.04214357554394121e-03, -3.94935680302138919e-03, -8.38755042927789504e-03, -1.01976709986859090e-02, 3.85542684158291351e-03, 5.74720470770017089e-02},
+	},
+	{	// C4, u^0 .. u^11
+		{4.60909261432979501e-04, 4.29819320151285215e-04, 3.69804367797562912e-04, 2.87295738898591855e-04, 1.95201205886277201e-04, 1.11469793643609395e-04, 5.05913862323685947e-05, 1.12685291398804489e-05},
+		{-1.25466917836866888e-04, -3.69403471983231659e-04, -5.82631760265149459e-04, -7.20189190747473791e-04, -7.28233287309692861e-04, -5.90152037812687589e-04, -3.85302727848269087e-04, -2.68789066881010297e-04},
+		{-9.99791142274120744e-04, -9.36821727976394343e-04, -7.38336723840405935e-04, -3.23027767251006471e-04, 2.74495086873719461e-04, 7.77670661369860624e-04, 7.41622259616973260e-04, 1.69727048560519236e-04},
+		{6.50921919068504431e-05, 3.05782025699107441e-04, 7.94754020734339648e-04, 1.41166403879041378e-03, 1.65142389193539290e-03, 8.08902979934279461e-04, -1.06173222412692743e-03, -1.28178628065220290e-03},
+		{2.99880553479107308e-04, 7.14785794170128648e-04, 1.20641129610200414e-03, 1.08923512960403283e-03, -3.95342134016268430e-04, -3.02517932152940620e-03, -3.62456186351197166e-03, 4.97723442418408941e-03},
+		{3.75097741418792643e-04, 8.63786616485823829e-04, 5.21455877237376802e-04, -1.12528787751507145e-03, -3.62384784122823846e-03, -3.99577898103442922e-03, 4.10999964635828767e-03, 2.53363686442542452e-02},
+		{9.43911017380645611e-04, 2.31087458898427198e-04, -1.26672221945066236e-03, -3.06312431260172052e-03, -2.97224992090745722e-03, 3.47249646749176735e-03, 1.95925724363860305e-02, 3.41535096225872165e-02},
+		{-3.88683706304226930e-04, -1.26634134799200678e-03, -2.08846391675421034e-03, -1.62116623589516392e-03, 2.72641002850185828e-03, 1.28783225881641955e-02, 2.23531879989667739e-02, 1.70363010123724431e-03},
+		{-7.99837980565914781e-04, -9.42230551775928723e-04, -5.05187706998791366e-04, 1.89621034536246839e-03, 7.24122589912412108e-03, 1.22497793017810816e-02, 2.02422862690741605e-03, -5.38331972381503668e-02},
+		{-1.14755624946778201e-04, -3.25381960970596643e-05, 1.02630491596947650e-03, 3.44129962054939799e-03, 5.69385630034586337e-03, 1.11310049367947567e-03, -2.40665179832483603e-02, -7.96119450586820904e-02},
+		{-1.40473604989159039e-04, 3.69341475999906889e-04, 1.39885621219102731e-03, 2.29570056094761683e-03, 4.04197778248237467e-04, -9.79476113126422770e-03, -3.24595172713618152e-02, -5.19459507296766709e-02},
+		{1.77173063663332506e-04, 5.73405358451471009e-04, 8.63336204937183247e-04, 1.40293142968910277e-04, -3.58713862135640440e-03, -1.19529650843566426e-02, -1.96261342417545885e-02, -5.12195624893006600e-04},
+	},
+};
+
+// Estrin for CHEB_DEG = 11
+static inline __attribute__((always_inline)) double rs_cheb_eval(const double (*c)[CHEB_SEG], const int seg,
+		const double u, const double u2, const double u4, const double u8)
+{
+	const double a0 = c[0][seg] + c[1][seg]*u;
+	const double a1 = c[2][seg] + c[3][seg]*u;
+	const double a2 = c[4][seg] + c[5][seg]*u;
+	const double a3 = c[6][seg] + c[7][seg]*u;
+	const double a4 = c[8][seg] + c[9][seg]*u;
+	const double a5 = c[10][seg] + c[11][seg]*u;
+	return (a0 + a1*u2) + u4*(a2 + a3*u2) + u8*(a4 + a5*u2);
+}
+
+#ifndef C_PROG
+struct paw_t {
+	int    seg;	// segment of |z|
+	double u;	// |z| - middle of the segment
+	double u2;
+	double u4;
+	double u8;
+	double sgn;	// sign of z, for the odd C1 and C3
+
+	inline paw_t(const double &z) 
+	{
+		const double w = fabs(z);
+		seg = (int)(w*CHEB_SEG);
+		seg = (seg < CHEB_SEG) ? seg : CHEB_SEG - 1;
+		u   = w - ((double)seg + 0.5)*(1.0/CHEB_SEG);
+		u2  = u*u;
+		u4  = u2*u2;
+		u8  = u4*u4;
+		sgn = copysign(1.0, z);
+	}
+
+};
+
+inline double C0(const paw_t &paw) { return rs_cheb_eval(rs_cheb[0], paw.seg, paw.u, paw.u2, paw.u4, paw.u8); }
+inline double C1(const paw_t &paw) { return paw.sgn*rs_cheb_eval(rs_cheb[1], paw.seg, paw.u, paw.u2, paw.u4, paw.u8); }
+inline double C2(const paw_t &paw) { return rs_cheb_eval(rs_cheb[2], paw.seg, paw.u, paw.u2, paw.u4, paw.u8); }
+inline double C3(const paw_t &paw) { return paw.sgn*rs_cheb_eval(rs_cheb[3], paw.seg, paw.u, paw.u2, paw.u4, paw.u8); }
+inline double C4(const paw_t &paw) { return rs_cheb_eval(rs_cheb[4], paw.seg, paw.u, paw.u2, paw.u4, paw.u8); }
+
+#else
+typedef struct paw_s {
+	int    seg;	// segment of |z|
+	double u;	// |z| - middle of the segment
+	double u2;
+	double u4;
+	double u8;
+	double sgn;	// sign of z, for the odd C1 and C3
+} paw_t;
+
+inline __attribute__((always_inline)) void paw_init(paw_t *paw, const double z) 
+{
+	const double w = fabs(z);
+	const int seg = (int)(w*CHEB_SEG);
+	paw->seg = (seg < CHEB_SEG) ? seg : CHEB_SEG - 1;
+	paw->u   = w - ((double)paw->seg + 0.5)*(1.0/CHEB_SEG);
+	paw->u2  = paw->u*paw->u;
+	paw->u4  = paw->u2*paw->u2;
+	paw->u8  = paw->u4*paw->u4;
+	paw->sgn = copysign(1.0, z);
+}
+
+static inline double C0(const paw_t *paw) { return rs_cheb_eval(rs_cheb[0], paw->seg, paw->u, paw->u2, paw->u4, paw->u8); }
+static inline double C1(const paw_t *paw) { return paw->sgn*rs_cheb_eval(rs_cheb[1], paw->seg, paw->u, paw->u2, paw->u4, paw->u8); }
+static inline double C2(const paw_t *paw) { return rs_cheb_eval(rs_cheb[2], paw->seg, paw->u, paw->u2, paw->u4, paw->u8); }
+static inline double C3(const paw_t *paw) { return paw->sgn*rs_cheb_eval(rs_cheb[3], paw->seg, paw->u, paw->u2, paw->u4, paw->u8); }
+static inline double C4(const paw_t *paw) { return rs_cheb_eval(rs_cheb[4], paw->seg, paw->u, paw->u2, paw->u4, paw->u8); }
+#endif
+
+
+/*
+	Remainder of one sample, branch free so that a simd loop over the
+	samples (R_batch, the tile epilogues) keeps every step in vectors :
+	with x = (2pi/t)^1/2 the sum C0 + C1 x + ... + C4 x^4 is a Horner in x,
+	even(N-1) is an integer sign and (2pi/t)^1/4 = sqrt(x), no pow().
+*/
+static inline __attribute__((always_inline)) double R_lane(const double t, const double p, const int N)
+{
+	const double two_pi = 2.0 * 3.1415926535897932385;
+	const double x = sqrt(two_pi/t);
+#ifndef C_PROG
+	paw_t paw(2.0*p - 1.0);
+#else
+	paw_t paw_v;
+	paw_t *paw=&paw_v;
+	paw_init(paw,2.0*p - 1.0);
+#endif
+	const double Rk = C0(paw) + x*(C1(paw) + x*(C2(paw) + x*(C3(paw) + x*C4(paw))));
+	return (double)even(N-1) * sqrt(x) * Rk;
+}
+
+double R_term(double t, double p, int N)
+//*************************************************************************
+// Remainder of the Riemann-Siegel formula, p is the fractional part of
+// sqrt(t/(2.0*pi)) and N its integer part
+//*************************************************************************
+{
+	// for (int k=0;k <= n;k++) {
+	// 	R = R + C(k,2.0*p-1.0) * pow(2.0*pi/t, ((double) k)*0.5);
+	// } 
+	// R = even(N-1) * pow(2.0 * pi / t,0.25) * R;
+	return R_lane(t, p, N);
+}
+
+/*
+	Remainders of a batch of samples : Ns[i] and R[i] for t[i]. The x86
+	versions keep 4 (avx2) or 8 (avx512) samples in the lanes, paw_t as
+	one register per field : the coefficients of the 8 segments are one
+	zmm per power of u (rs_cheb is laid out for that), the avx512 version
+	picks them with a permute, the avx2 one with a gather. Same steps as
+	R_lane, so the remainder keeps up with the vectorized main sums.
+	The engines that walk a block of samples (rotor, os, taylor) call it
+	R_BLOCK samples at a time.
+*/
+
+#ifndef R_BLOCK
+#define R_BLOCK 64
+#endif
+
+typedef void (*R_batch_t)(const double *t, int *Ns, double *R, const size_t n);
+
+void R_batch_portable(const double *t, int *Ns, double *R, const size_t n)
+{
+	const double two_pi = 2.0 * 3.1415926535897932385;
+
+	for (size_t i = 0; i < n; i++)
+	{
+		const double tmp = sqrt(t[i]/two_pi);
+		const int N = (int)tmp;
+		R[i]  = R_lane(t[i], tmp - (double)N, N);
+		Ns[i] = N;
+	}
+}
+
+#ifdef X86_SIMD
+__attribute__((target("avx2,fma"))) void R_batch_avx2(const double *t, int *Ns, double *R, const size_t n)
+{
+	const __m256d two_pi = _mm256_set1_pd(2.0 * 3.1415926535897932385);
+	const __m256d one    = _mm256_set1_pd(1.0);
+	const __m256d sign   = _mm256_set1_pd(-0.0);
+	const __m256d all    = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m256d tv  = _mm256_loadu_pd(t + i);
+		const __m256d tmp = _mm256_sqrt_pd(_mm256_div_pd(tv, two_pi));
+		const __m256d Nd  = _mm256_floor_pd(tmp);
+		const __m256d z   = _mm256_fmsub_pd(_mm256_set1_pd(2.0), _mm256_sub_pd(tmp, Nd), one);
+		const __m256d w   = _mm256_andnot_pd(sign, z);
+		const __m256d sd  = _mm256_min_pd(_mm256_floor_pd(_mm256_mul_pd(w, _mm256_set1_pd(CHEB_SEG))),
+					_mm256_set1_pd(CHEB_SEG - 1));
+		const __m128i seg = _mm256_cvttpd_epi32(sd);
+		const __m256d u   = _mm256_sub_pd(w, _mm256_mul_pd(_mm256_add_pd(sd, _mm256_set1_pd(0.5)), _mm256_set1_pd(1.0/CHEB_SEG)));
+		const __m256d u2  = _mm256_mul_pd(u, u);
+		const __m256d u4  = _mm256_mul_pd(u2, u2);
+		const __m256d u8  = _mm256_mul_pd(u4, u4);
+		__m256d C[5];
+		for (int k = 0; k < 5; k++)
+		{
+			__m256d a[6];
+			for (int q = 0; q < 6; q++)
+				a[q] = _mm256_fmadd_pd(_mm256_mask_i32gather_pd(_mm256_setzero_pd(), rs_cheb[k][2*q+1], seg, all, 8), u,
+						_mm256_mask_i32gather_pd(_mm256_setzero_pd(), rs_cheb[k][2*q], seg, all, 8));
+			C[k] = _mm256_fmadd_pd(u8, _mm256_fmadd_pd(a[5], u2, a[4]),
+				_mm256_fmadd_pd(u4, _mm256_fmadd_pd(a[3], u2, a[2]), _mm256_fmadd_pd(a[1], u2, a[0])));
+		}
+		// C1 and C3 are odd
+		const __m256d zs = _mm256_and_pd(sign, z);
+		C[1] = _mm256_xor_pd(C[1], zs);
+		C[3] = _mm256_xor_pd(C[3], zs);
+		const __m256d x  = _mm256_sqrt_pd(_mm256_div_pd(two_pi, tv));
+		__m256d Rk = _mm256_fmadd_pd(x, C[4], C[3]);
+		Rk = _mm256_fmadd_pd(x, Rk, C[2]);
+		Rk = _mm256_fmadd_pd(x, Rk, C[1]);
+		Rk = _mm256_fmadd_pd(x, Rk, C[0]);
+		Rk = _mm256_mul_pd(_mm256_sqrt_pd(x), Rk);
+		// even(N-1) : minus for N even
+		const __m256d half_N = _mm256_mul_pd(Nd, _mm256_set1_pd(0.5));
+		const __m256d N_even = _mm256_cmp_pd(_mm256_floor_pd(half_N), half_N, _CMP_EQ_OQ);
+		_mm256_storeu_pd(R + i, _mm256_xor_pd(Rk, _mm256_and_pd(N_even, sign)));
+		_mm_storeu_si128((__m128i *)(Ns + i), _mm256_cvttpd_epi32(Nd));
+	}
+	R_batch_portable(t + i, Ns + i, R + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void R_batch_avx512(const double *t, int *Ns, double *R, const size_t n)
+{
+	const __m512d two_pi = _mm512_set1_pd(2.0 * 3.1415926535897932385);
+	const __m512d one    = _mm512_set1_pd(1.0);
+	const __m512d magic  = _mm512_set1_pd(round_magic);
+	const __m512i sign   = _mm512_set1_epi64((long long)0x8000000000000000ULL);
+	const int floor_mode = _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC;
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		const __m512d tv  = _mm512_loadu_pd(t + i);
+		const __m512d tmp = _mm512_maskz_sqrt_pd(0xFF, _mm512_div_pd(tv, two_pi));
+		const __m512d Nd  = _mm512_maskz_roundscale_pd(0xFF, tmp, floor_mode);
+		const __m512d z   = _mm512_fmsub_pd(_mm512_set1_pd(2.0), _mm512_sub_pd(tmp, Nd), one);
+		const __m512d w   = _mm512_abs_pd(z);
+		const __m512d sd  = _mm512_maskz_min_pd(0xFF, _mm512_maskz_roundscale_pd(0xFF, _mm512_mul_pd(w, _mm512_set1_pd(CHEB_SEG)), floor_mode),
+					_mm512_set1_pd(CHEB_SEG - 1));
+		// integers below 2^51 plus 1.5*2^52 : the integer in the low bits
+		const __m512i seg = _mm512_castpd_si512(_mm512_add_pd(sd, magic));
+		const __m512d u   = _mm512_sub_pd(w, _mm512_mul_pd(_mm512_add_pd(sd, _mm512_set1_pd(0.5)), _mm512_set1_pd(1.0/CHEB_SEG)));
+		const __m512d u2  = _mm512_mul_pd(u, u);
+		const __m512d u4  = _mm512_mul_pd(u2, u2);
+		const __m512d u8  = _mm512_mul_pd(u4, u4);
+		__m512d C[5];
+		for (int k = 0; k < 5; k++)
+		{
+			__m512d a[6];
+			for (int q = 0; q < 6; q++)
+				a[q] = _mm512_fmadd_pd(_mm512_maskz_permutexvar_pd(0xFF, seg, _mm512_loadu_pd(rs_cheb[k][2*q+1])), u,
+						_mm512_maskz_permutexvar_pd(0xFF, seg, _mm512_loadu_pd(rs_cheb[k][2*q])));
+			C[k] = _mm512_fmadd_pd(u8, _mm512_fmadd_pd(a[5], u2, a[4]),
+				_mm512_fmadd_pd(u4, _mm512_fmadd_pd(a[3], u2, a[2]), _mm512_fmadd_pd(a[1], u2, a[0])));
+		}
+		// C1 and C3 are odd
+		const __m512i zs = _mm512_and_epi64(sign, _mm512_castpd_si512(z));
+		C[1] = _mm512_castsi512_pd(_mm512_xor_epi64(_mm512_castpd_si512(C[1]), zs));
+		C[3] = _mm512_castsi512_pd(_mm512_xor_epi64(_mm512_castpd_si512(C[3]), zs));
+		const __m512d x  = _mm512_maskz_sqrt_pd(0xFF, _mm512_div_pd(two_pi, tv));
+		__m512d Rk = _mm512_fmadd_pd(x, C[4], C[3]);
+		Rk = _mm512_fmadd_pd(x, Rk, C[2]);
+		Rk = _mm512_fmadd_pd(x, Rk, C[1]);
+		Rk = _mm512_fmadd_pd(x, Rk, C[0]);
+		const __m512i v = _mm512_castpd_si512(_mm512_mul_pd(_mm512_maskz_sqrt_pd(0xFF, x), Rk));
+		// even(N-1) : minus for N even
+		const __mmask8 N_even = _mm512_testn_epi64_mask(_mm512_castpd_si512(_mm512_add_pd(Nd, magic)), _mm512_set1_epi64(1));
+		_mm512_storeu_pd(R + i, _mm512_castsi512_pd(_mm512_mask_xor_epi64(v, N_even, v, sign)));
+		_mm256_storeu_si256((__m256i *)(Ns + i), _mm512_mask_cvttpd_epi32(_mm256_setzero_si256(), 0xFF, Nd));
+	}
+	R_batch_portable(t + i, Ns + i, R + i, n - i);
+}
+#endif
+
+R_batch_t R_batch = R_batch_portable;
+
+/*************************************************************************
+	Mixed precision main sum (-k mixed)
+
+	Counting zeros only needs the sign of Z. The phase tt - t log j and its
+	reduction to [-pi/2, pi/2] stay in double, the polynomial, the product
+	and the partial sums are in float (twice the lanes), the partial sums
+	are moved to double every MIXED_BLOCK terms. With S the running sum of
+	|terms| and m the terms added in float by one accumulator, the result
+	is within
+		(MIXED_EPS_TERM + m 2^-24) S
+	of the double kernels : MIXED_EPS_TERM covers the float rounding of
+	the reduced phase, of j^-1/2 and of the polynomial (each under 2e-7).
+	Z() keeps the float sum when |Z| is over MIXED_SAFETY times its bound
+	and evaluates it again with the double kernels otherwise, so the sign,
+	hence the count, is the one of the double kernels.
+*************************************************************************/
+
+#ifndef MIXED_BLOCK
+#define MIXED_BLOCK 128
+#endif
+
+#ifndef MIXED_EPS_TERM
+#define MIXED_EPS_TERM 1e-6
+#endif
+
+#ifndef MIXED_SAFETY
+#define MIXED_SAFETY 2.0
+#endif
+
+static const double one_over_pi = 3.18309886183790671538e-01;
+
+// cos on [-pi/2, pi/2], Taylor to r^12 (error under 1e-8)
+static const float mixed_c1 = -1.0f/2.0f;
+static const float mixed_c2 =  1.0f/24.0f;
+static const float mixed_c3 = -1.0f/720.0f;
+static const float mixed_c4 =  1.0f/40320.0f;
+static const float mixed_c5 = -1.0f/3628800.0f;
+static const float mixed_c6 =  1.0f/479001600.0f;
+
+typedef double (*main_sum_mixed_t)(const double t, const double tt, const int j0, const int j1, double *bound);
+
+// cos(x) = (-1)^k cos(x - k pi) : reduction in double, polynomial in float
+static inline __attribute__((always_inline)) float rs_cos_mixed(const double x)
+{
+	const double ky = x*one_over_pi + round_magic;
+	const double k  = ky - round_magic;
+	uint64_t q;
+	memcpy(&q, &ky, sizeof(q));
+
+	double rd = x - k*(2.0*pio2_1);
+	rd = rd - k*(2.0*pio2_2);
+	const float r = (float)rd;
+	const float z = r*r;
+
+	float v = 1.0f + z*(mixed_c1 + z*(mixed_c2 + z*(mixed_c3 + z*(mixed_c4 + z*(mixed_c5 + z*mixed_c6)))));
+	uint32_t vb;
+	memcpy(&vb, &v, sizeof(vb));
+	vb ^= (uint32_t)(q & 1) << 31;
+	memcpy(&v, &vb, sizeof(v));
+	return v;
+}
+
+// Left to the auto-vectorizer, one accumulator may add a whole block
+SIMD_CLONES double main_sum_mixed_portable(const double t, const double tt, const int j0, const int j1, double *bound)
+{
+	const double *isq = table_isq();
+	const double *lgi = table_lgi();
+	double sum = 0.0, S = 0.0;
+
+	for (int jb = j0; jb <= j1; jb += MIXED_BLOCK)
+	{
+		const int je = (jb + MIXED_BLOCK - 1 < j1) ? jb + MIXED_BLOCK - 1 : j1;
+		float s = 0.0f, a = 0.0f;
+		#pragma omp simd reduction(+:s,a)
+		for (int j = jb; j <= je; j++)
+		{
+			const float v = (float)isq[TAB_STRIDE*j] * rs_cos_mixed(tt - t*lgi[TAB_STRIDE*j]);
+			s += v;
+			a += fabsf(v);
+		}
+		sum += s;
+		S   += a;
+	}
+	*bound = (MIXED_EPS_TERM + MIXED_BLOCK*5.9604644775390625e-08)*S;
+	return sum;
+}
+
+#ifdef X86_SIMD
+// Two vectors of 8 doubles into one of 16 floats
+static inline __attribute__((target("avx512f"))) __m512 pd_to_ps_avx512(const __m512d a, const __m512d b)
+{
+	// masked forms : the plain ones start from undefined registers (-Wmaybe-uninitialized)
+	const __m512d zero = _mm512_setzero_pd();
+	const __m256d fa = _mm256_castps_pd(_mm512_mask_cvtpd_ps(_mm256_setzero_ps(), 0xFF, a));
+	const __m256d fb = _mm256_castps_pd(_mm512_mask_cvtpd_ps(_mm256_setzero_ps(), 0xFF, b));
+	const __m512d lo = _mm512_mask_insertf64x4(zero, 0xFF, zero, fa, 0);
+	return _mm512_castpd_ps(_mm512_mask_insertf64x4(lo, 0xFF, lo, fb, 1));
+}
+
+// s + the two halves of v, in double
+static inline __attribute__((target("avx512f"))) __m512d add_ps_to_pd_avx512(const __m512d s, const __m512 v)
+{
+	const __m512d zero = _mm512_setzero_pd();
+	const __m256d z256 = _mm256_setzero_pd();
+	const __m256 lo = _mm256_castpd_ps(_mm512_mask_extractf64x4_pd(z256, 0xF, _mm512_castps_pd(v), 0));
+	const __m256 hi = _mm256_castpd_ps(_mm512_mask_extractf64x4_pd(z256, 0xF, _mm512_castps_pd(v), 1));
+	return _mm512_add_pd(_mm512_add_pd(s, _mm512_mask_cvtps_pd(zero, 0xFF, lo)), _mm512_mask_cvtps_pd(zero, 0xFF, hi));
+}
+
+// cos of the 16 phases x0, x1 : reduction in double, polynomial in float
+static inline __attribute__((target("avx512f"))) __m512 cos_mixed_avx512(const __m512d x0, const __m512d x1)
+{
+	const __m512d ky0 = _mm512_fmadd_pd(x0, _mm512_set1_pd(one_over_pi), _mm512_set1_pd(round_magic));
+	const __m512d ky1 = _mm512_fmadd_pd(x1, _mm512_set1_pd(one_over_pi), _mm512_set1_pd(round_magic));
+	const __m512d k0  = _mm512_sub_pd(ky0, _mm512_set1_pd(round_magic));
+	const __m512d k1  = _mm512_sub_pd(ky1, _mm512_set1_pd(round_magic));
+	__m512d r0 = _mm512_fnmadd_pd(k0, _mm512_set1_pd(2.0*pio2_1), x0);
+	__m512d r1 = _mm512_fnmadd_pd(k1, _mm512_set1_pd(2.0*pio2_1), x1);
+	r0 = _mm512_fnmadd_pd(k0, _mm512_set1_pd(2.0*pio2_2), r0);
+	r1 = _mm512_fnmadd_pd(k1, _mm512_set1_pd(2.0*pio2_2), r1);
+
+	const __m512 r = pd_to_ps_avx512(r0, r1);
+	const __m512 z = _mm512_mul_ps(r, r);
+	__m512 c = _mm512_set1_ps(mixed_c6);
+	c = _mm512_fmadd_ps(c, z, _mm512_set1_ps(mixed_c5));
+	c = _mm512_fmadd_ps(c, z, _mm512_set1_ps(mixed_c4));
+	c = _mm512_fmadd_ps(c, z, _mm512_set1_ps(mixed_c3));
+	c = _mm512_fmadd_ps(c, z, _mm512_set1_ps(mixed_c2));
+	c = _mm512_fmadd_ps(c, z, _mm512_set1_ps(mixed_c1));
+	c = _mm512_fmadd_ps(c, z, _mm512_set1_ps(1.0f));
+
+	// odd k : -cos, lanes 0-7 from x0
+	const __m512i one   = _mm512_set1_epi64(1);
+	const __mmask16 odd = _mm512_kunpackb(_mm512_test_epi64_mask(_mm512_castpd_si512(ky1), one),
+			_mm512_test_epi64_mask(_mm512_castpd_si512(ky0), one));
+	const __m512i v = _mm512_castps_si512(c);
+	return _mm512_castsi512_ps(_mm512_mask_xor_epi32(v, odd, v, _mm512_set1_epi32((int)0x80000000u)));
+}
+
+// 16 lanes, a lane adds MIXED_BLOCK/16 terms in float
+__attribute__((target("avx512f"))) double main_sum_mixed_avx512(const double t, const double tt, const int j0, const int j1, double *bound)
+{
+	const double *isq = table_isq();
+	const double *lgi = table_lgi();
+	const __m512d vt  = _mm512_set1_pd(t);
+	const __m512d vtt = _mm512_set1_pd(tt);
+	const int pf = (j1 - j0 >= TABLE_PREFETCH_MIN);
+	__m512d sum = _mm512_setzero_pd();
+	__m512d S   = _mm512_setzero_pd();
+
+	for (int jb = j0; jb <= j1; jb += MIXED_BLOCK)
+	{
+		const int je = (jb + MIXED_BLOCK - 1 < j1) ? jb + MIXED_BLOCK - 1 : j1;
+		__m512 acc  = _mm512_setzero_ps();
+		__m512 aacc = _mm512_setzero_ps();
+		for (int j = jb; j <= je; j += 16)
+		{
+			if (pf)
+			{
+				table_prefetch(isq, lgi, j);
+				table_prefetch(isq, lgi, j + 8);
+			}
+			// the lanes past je get a = 0
+			const int cnt = je - j + 1;
+			__m512d a0, l0, a1, l1;
+			terms_avx512(isq, lgi, j, (cnt < 8) ? cnt : 8, &a0, &l0);
+			terms_avx512(isq, lgi, j + 8, (cnt < 16) ? ((cnt > 8) ? cnt - 8 : 0) : 8, &a1, &l1);
+			const __m512d x0 = _mm512_fnmadd_pd(vt, l0, vtt);
+			const __m512d x1 = _mm512_fnmadd_pd(vt, l1, vtt);
+			const __m512 v = _mm512_mul_ps(pd_to_ps_avx512(a0, a1), cos_mixed_avx512(x0, x1));
+			acc  = _mm512_add_ps(acc, v);
+			aacc = _mm512_add_ps(aacc, _mm512_abs_ps(v));
+		}
+		sum = add_ps_to_pd_avx512(sum, acc);
+		S   = add_ps_to_pd_avx512(S, aacc);
+	}
+	double ls[8], lS[8];
+	_mm512_storeu_pd(ls, sum);
+	_mm512_storeu_pd(lS, S);
+	*bound = (MIXED_EPS_TERM + (MIXED_BLOCK/16)*5.9604644775390625e-08)
+		* (((lS[0] + lS[1]) + (lS[2] + lS[3])) + ((lS[4] + lS[5]) + (lS[6] + lS[7])));
+	return ((ls[0] + ls[1]) + (ls[2] + ls[3])) + ((ls[4] + ls[5]) + (ls[6] + ls[7]));
+}
+#endif
+
+main_sum_mixed_t main_sum_mixed = main_sum_mixed_portable;
+
+main_sum_t main_sum = main_sum_scalar;
+main_sum_tile_t main_sum_tile = main_sum_tile_scalar;
+
+// -k mixed : Z() tries the float main sum first (main_sum_mixed)
+int mixed_wanted = 0;
+
+// Select the main sum kernel by name, "auto" picks the widest one the cpu supports
+const char *select_kernel(const char *name)
+{
+	const int is_auto = !strcmp(name, "auto");
+#ifdef X86_SIMD
+	__builtin_cpu_init();
+	if ((is_auto || !strcmp(name, "avx512")) && __builtin_cpu_supports("avx512f")) {
+		main_sum = main_sum_avx512;
+		main_sum_tile = main_sum_tile_avx512;
+		R_batch = R_batch_avx512;
+		return "avx512";
+	}
+	if ((is_auto || !strcmp(name, "avx2")) && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+		main_sum = main_sum_avx2;
+		main_sum_tile = main_sum_tile_avx2;
+		R_batch = R_batch_avx2;
+		return "avx2";
+	}
+	if (is_auto || !strcmp(name, "sse2")) {
+		main_sum = main_sum_sse2;
+		main_sum_tile = main_sum_tile_sse2;
+		return "sse2";
+	}
+#endif
+#ifdef ARM
+	if (is_auto) {
+		main_sum = main_sum_scalar;
+		main_sum_tile = main_sum_tile_scalar;
+		return "scalar";
+	}
+#endif
+	if (is_auto || !strcmp(name, "portable")) {
+		main_sum = main_sum_portable;
+		main_sum_tile = main_sum_tile_portable;
+		return "portable";
+	}
+	if (!strcmp(name, "scalar")) {
+		main_sum = main_sum_scalar;
+		main_sum_tile = main_sum_tile_scalar;
+		return "scalar";
+	}
+	// the sieve for the whole main sums of Z(), the tables for the rest
+	if (!strcmp(name, "sieve")) {
+		select_kernel("auto");
+		sieve_wanted = 1;
+		return "sieve";
+	}
+	// float main sums for Z(), checked against their error bound
+	if (!strcmp(name, "mixed")) {
+		select_kernel("auto");
+#ifdef X86_SIMD
+		if (main_sum == main_sum_avx512)
+			main_sum_mixed = main_sum_mixed_avx512;
+#endif
+		mixed_wanted = 1;
+		return "mixed";
+	}
+	return NULL;
+}
+
+/*************************************************************************
+	Table-free main sum : 1/sqrt(j) and log(j) made in registers
+
+	Once the tables outgrow the caches the main sum waits on memory. Here
+	the terms come by blocks of GEN_BLOCK from a base b, with x = (j-b)/b
+		log(j)    = log(b) + log1p(x)
+		1/sqrt(j) = b^{-1/2} (1+x)^{-1/2}
+	both by their Taylor series up to x^7, x <= GEN_BLOCK/GEN_MIN_J = 2^-7
+	so what is left out is below the rounding of log(b). Only log(b) and
+	1/sqrt(b) go through libm, once per block, and the phase is
+	(tt - t log(b)) - t log1p(x), the large product is the one of the
+	table kernels. The terms below GEN_MIN_J still come from the tables
+	(2 x 128 kB, they stay in L2).
+	main_sum_terms() switches to it for the sums of gen_crossover terms or
+	more, by default once the tables do not fit in the last level cache.
+*************************************************************************/
+
+#ifndef GEN_BLOCK
+#define GEN_BLOCK 128
+#endif
+
+#ifndef GEN_MIN_J
+#define GEN_MIN_J 16384
+#endif
+
+int gen_crossover = 0;	// 0 : never
+
+SIMD_CLONES double main_sum_gen(const double t, const double tt, const int j0, const int j1)
+{
+	double ZZ = 0.0;
+	for (int b = j0; b <= j1; b += GEN_BLOCK)
+	{
+		const int m = (j1 - b + 1 < GEN_BLOCK) ? j1 - b + 1 : GEN_BLOCK;
+		const double inv_b = 1.0/(double)b;
+		const double isq_b = sqrt(inv_b);
+		const double ph_b  = tt - t*log((double)b);
+		double acc = 0.0;
+		#pragma omp simd reduction(+:acc)
+		for (int i = 0; i < m; i++)
+		{
+			const double x = (double)i*inv_b;
+			const double l1 = x*(1.0 - x*(1.0/2 - x*(1.0/3 - x*(1.0/4 - x*(1.0/5 - x*(1.0/6 - x*(1.0/7)))))));
+			const double r1 = 1.0 - x*(1.0/2 - x*(3.0/8 - x*(5.0/16 - x*(35.0/128 - x*(63.0/256 - x*(231.0/1024 - x*(429.0/2048)))))));
+			acc += isq_b*r1 * rs_cos(ph_b - t*l1);
+		}
+		ZZ += acc;
+	}
+	return ZZ;
+}
+
+// Number of terms from which the tables do not fit in the last level cache
+int gen_auto_crossover(void)
+{
+	long cache = 0;
+#if defined(__linux__) && defined(_SC_LEVEL3_CACHE_SIZE)
+	cache = sysconf(_SC_LEVEL3_CACHE_SIZE);
+	if (cache <= 0)
+		cache = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+	if (cache <= 0)
+		cache = 8L << 20;
+	const long n = cache/(2*sizeof(double));
+	return (n < GEN_MIN_J) ? GEN_MIN_J : (int)n;
+}
+
+/*************************************************************************
+	Sieve main sum : j^{-1/2} e^{-i t log j} is completely multiplicative
+
+	w_j = j^{-1/2} e^{-i t log j} = w_p w_{j/p} with p the smallest prime
+	factor of j (compute_sieve), so only the primes, about N/log N of
+	them, need a sincos and every other term is one complex multiply. The
+	two factors of a j in [J, 2J) are below J, so the terms are made
+	octave by octave, each octave is a simd loop (gathers). Then
+		sum_j j^{-1/2} cos(tt - t log j) = cos(tt) Re(W) - sin(tt) Im(W)
+	with W = sum_j w_j. A term carries the rounding of its prime factors
+	(log2 N of them at most), about the accuracy of the table kernels.
+	The terms (16 bytes each) are kept in a buffer per thread (sieve_bufs).
+*************************************************************************/
+
+static __thread sieve_buf_t *sieve_buf = NULL;
+static __thread int          sieve_buf_gen = -1;
+
+SIMD_CLONES double main_sum_sieve(const double t, const double tt, const int N)
+{
+	sieve_buf_t *sb = sieve_buf;
+	if (sb == NULL || sieve_buf_gen != sieve_gen)
+	{
+		sb = (sieve_buf_t *)calloc(1, sizeof(sieve_buf_t));
+		#pragma omp critical(sieve_bufs)
+		{
+			sb->next = sieve_bufs;
+			sieve_bufs = sb;
+		}
+		sieve_buf = sb;
+		sieve_buf_gen = sieve_gen;
+	}
+	if (N + 1 > sb->cap)
+	{
+		free(sb->w);
+		sb->cap = N + 1;
+		sb->w = (double *)malloc(2*(size_t)sb->cap*sizeof(double));
+	}
+	double * __restrict__ w_re = sb->w;
+	double * __restrict__ w_im = sb->w + sb->cap;
+	const double *isq = table_isq();
+	const double *lgi = table_lgi();
+	const int *spf = sieve_spf;
+	const int *cof = sieve_cof;
+	const int *primes = sieve_primes;
+
+	// primes up to N
+	int lo = 0, hi = sieve_nprimes;
+	while (lo < hi)
+	{
+		const int mid = (lo + hi)/2;
+		if (primes[mid] <= N)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	const int np = lo;
+	#pragma omp simd
+	for (int k = 0; k < np; k++)
+	{
+		const int p = primes[k];
+		double s, c;
+		rs_sincos(t*lgi[TAB_STRIDE*p], &s, &c);
+		w_re[p] =  isq[TAB_STRIDE*p]*c;
+		w_im[p] = -isq[TAB_STRIDE*p]*s;
+	}
+	w_re[1] = 1.0;
+	w_im[1] = 0.0;
+
+	// a prime j reads w_j w_1 = w_j, its own slot
+	double re = 1.0, im = 0.0;
+	for (ui64 J = 2; J <= (ui64)N; J *= 2)
+	{
+		const int e = (2*J - 1 < (ui64)N) ? (int)(2*J - 1) : N;
+		#pragma omp simd reduction(+:re,im)
+		for (int j = (int)J; j <= e; j++)
+		{
+			const int a = spf[j];
+			const int b = cof[j];
+			const double x_re = w_re[a]*w_re[b] - w_im[a]*w_im[b];
+			const double x_im = w_re[a]*w_im[b] + w_im[a]*w_re[b];
+			w_re[j] = x_re;
+			w_im[j] = x_im;
+			re += x_re;
+			im += x_im;
+		}
+	}
+	return cos(tt)*re - sin(tt)*im;
+}
+
+/*
+	sum_{j=j0}^{j1} : the whole sums by the sieve with -k sieve, otherwise
+	the tables or, for long sums, the table-free kernel above GEN_MIN_J
+*/
+double main_sum_terms(const double t, const double tt, const int j0, const int j1)
+{
+	if (sieve_wanted && j0 == 1)
+		return main_sum_sieve(t, tt, j1);
+	if (gen_crossover == 0 || j1 < gen_crossover || j1 < GEN_MIN_J)
+		return main_sum(t, tt, j0, j1);
+	if (j0 >= GEN_MIN_J)
+		return main_sum_gen(t, tt, j0, j1);
+	return main_sum(t, tt, j0, GEN_MIN_J - 1) + main_sum_gen(t, tt, GEN_MIN_J, j1);
+}
+
+
+/*************************************************************************
+	Split evaluation : one Z(t) over all the threads
+
+	Above 1e13 the main sum has millions of terms and a single Z() is
+	worth spreading (zero refinement, spot checks). The terms are cut in
+	slices of SPLIT_TERMS, a fixed size, the slices are shared between the
+	threads and their partial sums are added by a pairwise tree in slice
+	order, so the result does not depend on the number of threads. Called
+	from inside a parallel region the slices run on the calling thread
+	with the same result.
+*************************************************************************/
+
+#ifndef SPLIT_TERMS
+#define SPLIT_TERMS 65536
+#endif
+
+// Z() splits its main sum from this number of terms on (option -p)
+#ifndef SPLIT_MIN_TERMS
+#define SPLIT_MIN_TERMS 262144
+#endif
+
+int split_eval = 0;
+
+double main_sum_split(const double t, const double tt, const int N)
+{
+	const int slices = (N + SPLIT_TERMS - 1)/SPLIT_TERMS;
+	double *part = (double *)malloc(slices*sizeof(double));
+	#pragma omp parallel for schedule(dynamic)
+	for (int k = 0; k < slices; k++)
+	{
+		const int j1 = (N - k*SPLIT_TERMS < SPLIT_TERMS) ? N : (k + 1)*SPLIT_TERMS;
+		part[k] = main_sum_terms(t, tt, k*SPLIT_TERMS + 1, j1);
+	}
+	for (int w = 1; w < slices; w *= 2)
+		for (int k = 0; k + w < slices; k += 2*w)
+			part[k] += part[k+w];
+	const double ZZ = part[0];
+	free(part);
+	return ZZ;
+}
+
+/*************************************************************************
+	Precision ladder (option -q)
+
+	Z() in double comes with a rigorous bound of its rounding errors. With
+	theta reduced mod 2pi in long double (theta_mod), a term loses to the
+	roundings of log_int[j], of t log j, of the subtraction and of the
+	reduction of the cosine at most PREC_ULPS u t log j, u = 2^-53, so
+	with sum_{j<=N} j^-1/2 log j < 2 sqrt(N) (log N - 2) + 5 the bound
+	grows like u t sqrt(N) log N : about 1e-3 at 1e9, about 1 at 1e11.
+	A sample whose |Z| is under its bound goes up the ladder :
+	  - Z_dd : log j = log_int[j] + prec_log_lo[j], theta in __float128,
+	    the phase reduced mod 2pi in double-double, the cosine of the
+	    reduced phase in double. Blocks of PREC_BLOCK terms are summed in
+	    double, the blocks with a compensated sum. About 1e-11 at 1e11.
+	  - Z_quad : the main sum in __float128 with our own logarithm and
+	    cosine, no libquadmath.
+	A sample still under the __float128 bound is counted as unresolved.
+	The remainder stays in double at every level, its rounding and its
+	truncation after C4 are part of every bound.
+*************************************************************************/
+
+#ifndef PREC_ULPS
+#define PREC_ULPS 6.0
+#endif
+
+#ifndef PREC_BLOCK
+#define PREC_BLOCK 256
+#endif
+
+// truncation of the remainder after C4, times (2pi/t)^(11/4)
+#define PREC_RS_TAIL 0.05
+
+static const double prec_u = 1.1102230246251565e-16;	// 2^-53
+
+// samples escalated to double-double, to __float128, unresolved
+double prec_count[3] = {0.0, 0.0, 0.0};
+
+// theta(T0 + d) mod 2pi in long double
+double theta_mod(const double T0, const double d)
+{
+	const long double pi = 3.14159265358979323846264338327950288L;
+	const long double t = (long double)T0 + (long double)d;
+	const long double t_div_2 = 0.5L*t;
+	const long double th = t_div_2*logl(t_div_2/pi) - t_div_2 - 0.125L*pi
+			+ 1.0L/(48.0L*t) + 7.0L/(5760.0L*t*t*t);
+	return (double)fmodl(th, 2.0L*pi);
+}
+
+// theta(t), same series as theta() in __float128
+f128_t q_theta(const double t)
+{
+	const f128_t pi = f128_sum(3.14159265358979312e+00, 1.22464679914735321e-16, -2.99476980971833967e-33);
+	const f128_t h  = 0.5*(f128_t)t;
+	const f128_t i1 = 1/(f128_t)t;
+	const f128_t i2 = i1*i1;
+	return h*q_log(h/pi) - h - pi/8
+		+ i1*((f128_t)1/48 + i2*((f128_t)7/5760 + i2*((f128_t)31/80640
+		+ i2*((f128_t)127/430080 + i2*(f128_t)511/1216512))));
+}
+
+// 1/((2n-1) 2n) and 1/(2n (2n+1)), n = 1..15 : the Taylor steps of q_cos without a division
+static const f128_t q_cos_rc[16] = {0, (f128_t)1/2, (f128_t)1/12, (f128_t)1/30, (f128_t)1/56, (f128_t)1/90,
+	(f128_t)1/132, (f128_t)1/182, (f128_t)1/240, (f128_t)1/306, (f128_t)1/380, (f128_t)1/462,
+	(f128_t)1/552, (f128_t)1/650, (f128_t)1/756, (f128_t)1/870};
+static const f128_t q_cos_rs[16] = {0, (f128_t)1/6, (f128_t)1/20, (f128_t)1/42, (f128_t)1/72, (f128_t)1/110,
+	(f128_t)1/156, (f128_t)1/210, (f128_t)1/272, (f128_t)1/342, (f128_t)1/420, (f128_t)1/506,
+	(f128_t)1/600, (f128_t)1/702, (f128_t)1/812, (f128_t)1/930};
+
+// cos x : x - k pi/2 in three parts, Taylor to r^31 on |r| <= pi/4, only the
+// one of cos r, sin r that the quadrant needs
+f128_t q_cos(const f128_t x)
+{
+	const double kd = nearbyint((double)x*two_over_pi);
+	const int    q  = (int)((int64_t)kd & 3);
+	const f128_t k  = kd;
+	const f128_t r  = ((x - k*(f128_t)1.57079632679489656e+00) - k*(f128_t)6.12323399573676604e-17)
+			- k*(f128_t)(-1.49738490485916983e-33);
+	const f128_t z  = r*r;
+	const f128_t *rc = (q & 1) ? q_cos_rs : q_cos_rc;
+	f128_t c = 1;
+	for (int n = 15; n >= 1; n--)
+		c = 1 - z*c*rc[n];
+	if (q & 1)
+		c *= r;
+	// cos, -sin, -cos, sin
+	return (q == 1 || q == 2) ? -c : c;
+}
+
+// truncation of the remainder : no precision of the main sum goes below it
+static inline double R_tail(const double t)
+{
+	return PREC_RS_TAIL*pow(2.0*3.1415926535897932385/t, 2.75);
+}
+
+// bound of the rounding and truncation errors of the remainder
+static inline double R_bound(const double t, const double R)
+{
+	return 8.0*prec_u*fabs(R) + R_tail(t);
+}
+
+// bound of |Z - Z()| for Z() in double with theta from theta_mod
+double Z_bound(const double t, const int N, const double R)
+{
+	const double sq = 2.0*sqrt((double)N);
+	const double lg = (N > 1) ? sq*(log((double)N) - 2.0) + 5.0 : 1.0;
+	const double e_theta = 8.7e-19*t*log(t) + 4e-4/(t*t*t*t*t);
+	return 2.0*(PREC_ULPS*prec_u*t*lg + (e_theta + 8.0*prec_u)*sq) + R_bound(t, R);
+}
+
+/*
+	Main sum in double-double, theta = th + tl. *bound gets the bound of
+	its error : the reduced phase is good to a few u, a block sum loses
+	PREC_BLOCK u times the sum of its |terms|.
+*/
+SIMD_CLONES double main_sum_dd(const double t, const double th, const double tl, const int N, double *bound)
+{
+	const double *isq = table_isq();
+	const double *lgi = table_lgi();
+	const double *lo  = prec_log_lo;
+	const double two_pi_1 = 6.28318530717958623e+00;
+	const double two_pi_2 = 2.44929359829470641e-16;
+	const double two_pi_3 = -5.98953961943667933e-33;
+	const double inv_two_pi = 0.15915494309189535;
+	double s = 0.0, c = 0.0, S = 0.0;
+	for (int j0 = 1; j0 <= N; j0 += PREC_BLOCK)
+	{
+		const int j1 = (N - j0 < PREC_BLOCK) ? N : j0 + PREC_BLOCK - 1;
+		double b = 0.0, a = 0.0;
+		#pragma omp simd reduction(+:b,a)
+		for (int j = j0; j <= j1; j++)
+		{
+			const double l  = lgi[TAB_STRIDE*j];
+			const double p  = t*l;
+			const double e  = fma(t, l, -p) + t*lo[j];	// t log j = p + e
+			const double sh = th - p;
+			const double bb = sh - th;
+			const double sl = ((th - (sh - bb)) - (p + bb)) + (tl - e);
+			const double k  = (sh*inv_two_pi + round_magic) - round_magic;
+			double r = fma(-k, two_pi_1, sh);
+			r = fma(-k, two_pi_2, r);
+			r = fma(-k, two_pi_3, r) + sl;
+			const double v = isq[TAB_STRIDE*j]*rs_cos(r);
+			b += v;
+			a += fabs(v);
+		}
+		const double y = s + b;
+		c += (fabs(s) >= fabs(b)) ? (s - y) + b : (b - y) + s;
+		s = y;
+		S += a;
+	}
+	*bound = (PREC_BLOCK*prec_u)*S + 40.0*prec_u*2.0*sqrt((double)N) + 4.0*prec_u*fabs(s);
+	return s + c;
+}
+
+// Main sum in __float128
+f128_t main_sum_quad(const double t, const f128_t th, const int N)
+{
+	const double *isq = table_isq();
+	const double *lgi = table_lgi();
+	const f128_t tq = t;
+	f128_t sum = 0;
+	for (int j = 1; j <= N; j++)
+	{
+		// one Newton step on j^-1/2
+		const f128_t y = isq[TAB_STRIDE*j];
+		const f128_t w = y + 0.5*y*(1 - (f128_t)j*y*y);
+		const f128_t L = (f128_t)lgi[TAB_STRIDE*j] + (f128_t)prec_log_lo[j];
+		sum += w*q_cos(th - tq*L);
+	}
+	return sum;
+}
+
+/*
+	Z0 = Z(t) in double, up the ladder while its sign is not sure. A sample
+	whose |Z0| is under the truncation of the remainder (small t) stays
+	unresolved at every level : it is reported at once.
+*/
+double Z_ladder(const double t, const int N, const double R, const double Z0, const double B0)
+{
+	if (fabs(Z0) > B0)
+		return Z0;
+	if (fabs(Z0) <= R_tail(t))
+	{
+		#pragma omp atomic
+		prec_count[2] += 1.0;
+		return Z0;
+	}
+	#pragma omp atomic
+	prec_count[0] += 1.0;
+
+	const f128_t th = q_theta(t);
+	const double th_hi = (double)th;
+	const double th_lo = (double)(th - (f128_t)th_hi);
+	double b1;
+	const double Z1 = 2.0*main_sum_dd(t, th_hi, th_lo, N, &b1) + R;
+	b1 = 2.0*(b1 + 2e-32*fabs(th_hi)*sqrt((double)N)) + R_bound(t, R);
+	if (fabs(Z1) > b1)
+		return Z1;
+	#pragma omp atomic
+	prec_count[1] += 1.0;
+
+	const double Z2 = (double)(2*main_sum_quad(t, th, N)) + R;
+	const double b2 = 2.0*(1e-31*t*log(t) + 1e-32)*2.0*sqrt((double)N) + 2.0*prec_u*fabs(Z2) + R_bound(t, R);
+	if (fabs(Z2) <= b2)
+	{
+		#pragma omp atomic
+		prec_count[2] += 1.0;
+	}
+	return Z2;
+}
+
+double Z_theta(double t, double theta_t)
+//*************************************************************************
+// Riemann-Siegel Z(t) function implemented per the Riemenn Siegel formula.
+// See http://mathworld.wolfram.com/Riemann-SiegelFormula.html for details
+// theta_t is theta(t), computed by the caller
+//*************************************************************************
+{
+	double p; /* fractional part of sqrt(t/(2.0*pi))*/
+	// double C(int,double); /* coefficient of (2*pi/t)^(k*0.5) */
+#ifndef C_PROG
+	constexpr double pi = 3.1415926535897932385; 
+	constexpr double two_pi = 2.0 * pi;
+#else
+	const double pi = 3.1415926535897932385;
+	const double two_pi = 2.0 * pi;
+#endif
+	double tmp = sqrt(t/two_pi); 
+	int N = (int)tmp;
+		p = tmp - (double)N;
+	double tt = prec_ladder ? theta_mod(t, 0.0) : theta_t; 
+	const double R = R_term(t, p, N);
+	const double B0 = prec_ladder ? Z_bound(t, N, R) : 0.0;
+	if (mixed_wanted && !(split_eval && N >= SPLIT_MIN_TERMS))
+	{
+		double bound;
+		const double ZM = 2.0*main_sum_mixed(t, tt, 1, N, &bound) + R;
+		if (fabs(ZM) > MIXED_SAFETY*2.0*bound + B0)
+			return ZM;
+	}
+	double ZZ = (split_eval && N >= SPLIT_MIN_TERMS) ? main_sum_split(t, tt, N) : main_sum_terms(t, tt, 1, N);
+	ZZ = 2.0 * ZZ; 
+
+	if (prec_ladder)
+		return Z_ladder(t, N, R, ZZ + R, B0);
+	return(ZZ + R);
+}
+
+double Z(double t)
+{
+	return Z_theta(t, theta(t));
+}
+
+/*************************************************************************
+	Sample engines : Z on n consecutive samples t0, t0+h, ..., t0+(n-1)h
+
+	ENGINE_DIRECT calls Z() on every sample.
+
+	ENGINE_TILE evaluates TILE_K neighbouring samples together with the
+	main_sum_tile kernel, so the tables are streamed once per tile.
+
+	ENGINE_OS is the Odlyzko-Schonhage idea : the main sums of a whole block
+	of samples come out of one FFT (see Z_os below).
+
+	ENGINE_ROTOR keeps w_j = j^{-1/2} e^{-i t log j} for every term and
+	moves it to the next sample with the constant rotor e^{-i h log j},
+	the main sum is then a complex multiply-add per term, no cosine :
+		sum_j j^{-1/2} cos(theta - t log j) = cos(theta) Re(W) - sin(theta) Im(W)
+	with W = sum_j w_j.
+	The products drift by about one ulp per step, so the state is recomputed
+	exactly every ROTOR_SYNC samples.
+
+	ENGINE_TAYLOR expands the main sum in powers of t-t0 over short
+	windows of samples (see Z_taylor below).
+
+	ENGINE_OFFSET writes t = T0 + d with T0 log j mod 2pi in long double,
+	for the phases at large t (see Z_offset below).
+
+	Except ENGINE_OFFSET, the engines get theta of their samples from
+	theta_run, computed once per block of samples.
+*************************************************************************/
+
+#ifndef ROTOR_SYNC
+#define ROTOR_SYNC 1024
+#endif
+
+#ifndef ROTOR_TERMS
+#define ROTOR_TERMS 256
+#endif
+
+#ifndef SAMPLE_BLOCK
+#define SAMPLE_BLOCK 4096
+#endif
+
+/*
+	theta on consecutive samples : theta() is exact at the first sample tb
+	of a run, the next ones are its Taylor expansion in d = t - tb,
+		theta(tb) + theta'(tb) d + theta''(tb) d^2/2 + ... + theta''''(tb) d^4/24
+	with theta' = log(t/2pi)/2 - 1/48t^2 - 7/1920t^4, theta'' = 1/2t + 1/24t^3,
+	theta''' = -1/2t^2 - 1/8t^4, theta'''' = 1/t^3. A run is THETA_SYNC
+	samples, shorter when d would pass THETA_REACH tb : the first term left
+	out, about d^5/40tb^4, then stays under 1e-15 tb, below an ulp of theta.
+	One log and one division per run, no libm call per sample.
+*/
+#ifndef THETA_SYNC
+#define THETA_SYNC 4096
+#endif
+
+#define THETA_REACH 1e-3
+
+SIMD_CLONES void theta_taylor(const double tb, const double *t, double *tt, const size_t m)
+{
+	const double pi = 3.1415926535897932385;
+	const double i1 = 1.0/tb;
+	const double i2 = i1*i1;
+	const double c0 = theta(tb);
+	const double c1 = 0.5*log(tb/(2.0*pi)) - i2*(1.0/48.0 + i2*(7.0/1920.0));
+	const double c2 = i1*(0.25 + i2*(1.0/48.0));
+	const double c3 = -i2*(1.0/12.0 + i2*(1.0/48.0));
+	const double c4 = i2*i1*(1.0/24.0);
+
+	#pragma omp simd
+	for (size_t i = 0; i < m; i++)
+	{
+		const double d = t[i] - tb;
+		tt[i] = c0 + d*(c1 + d*(c2 + d*(c3 + d*c4)));
+	}
+}
+
+// tt[i] = theta(t[i]) for n increasing and evenly spaced t[i]
+void theta_run(const double *t, double *tt, const ui64 n)
+{
+	ui64 b = 0;
+	while (b < n)
+	{
+		ui64 m = (n - b < THETA_SYNC) ? n - b : THETA_SYNC;
+		while (m > 1 && t[b+m-1] - t[b] > THETA_REACH*t[b])
+			m /= 2;
+		theta_taylor(t[b], t + b, tt + b, m);
+		b += m;
+	}
+}
+
+typedef enum { ENGINE_DIRECT, ENGINE_ROTOR, ENGINE_TILE, ENGINE_OS, ENGINE_TAYLOR, ENGINE_OFFSET } engine_t;
+engine_t engine = ENGINE_DIRECT;
+
+typedef enum { SAMPLING_UNIFORM, SAMPLING_GRAM, SAMPLING_ADAPTIVE } sampling_t;
+sampling_t sampling = SAMPLING_UNIFORM;
+
+typedef struct rotor_s {
+	int     size;	// allocated terms
+	int     N;	// terms whose rotor is computed for h
+	double  h;
+	double *w_re;
+	double *w_im;
+	double *r_re;
+	double *r_im;
+	int    *Ns;	// per sample of the block : number of terms
+	double *R;	// per sample of the block : remainder
+	double *W_re;	// per sample of the block : sum of w_j
+	double *W_im;
+} rotor_t;
+
+typedef struct os_s {
+	int     M;	// outputs of the transform (power of 2), the grid has OS_OVERSAMPLE*M points
+	double  tau;	// gaussian width
+	double *grid;	// complex, interleaved
+	double *twiddle;	// e^{-2 i pi k/Mr}, k < Mr/2
+	double *E3;	// e^{-(l dxi)^2/(4 tau)}, -OS_SPREAD < l <= OS_SPREAD
+	double *decon;	// sqrt(pi/tau) e^{k^2 tau}/Mr, -M/2 <= k < M/2
+	double *F;	// complex main sums of the block
+} os_t;
+
+typedef struct offset_s {
+	int     size;	// allocated terms
+	int     N;	// terms whose phase is computed for T0
+	double  T0;
+	double *ph;	// T0 log j mod 2pi
+} offset_t;
+
+typedef struct workspace_s {
+	rotor_t  rotor;
+	os_t     os;
+	offset_t offset;
+	double *zbuf;
+	double *tbuf;	// t of the samples of the block
+	double *ttbuf;	// theta of the samples of the block
+	double  refined;	// evaluations added by the adaptive refinement
+} workspace_t;
+
+void rotor_reserve(rotor_t *rt, int N, double h)
+{
+	if (N+1 > rt->size)
+	{
+		rt->size = 2*(N+1);
+		rt->w_re = (double *)realloc(rt->w_re, rt->size*sizeof(double));
+		rt->w_im = (double *)realloc(rt->w_im, rt->size*sizeof(double));
+		rt->r_re = (double *)realloc(rt->r_re, rt->size*sizeof(double));
+		rt->r_im = (double *)realloc(rt->r_im, rt->size*sizeof(double));
+	}
+	if (h != rt->h)
+	{
+		rt->h = h;
+		rt->N = 0;
+	}
+	const double *lgi = table_lgi();
+	for (int j = rt->N+1; j <= N; j++)
+	{
+		double s, c;
+		rs_sincos(h*lgi[TAB_STRIDE*j], &s, &c);
+		rt->r_re[j] =  c;
+		rt->r_im[j] = -s;
+	}
+	if (N > rt->N)
+		rt->N = N;
+}
+
+// Exact state at t for all j<=Nmax
+SIMD_CLONES void rotor_sync(rotor_t *rt, const double t, const int Nmax)
+{
+	const double * __restrict__ isq = table_isq();
+	const double * __restrict__ lgi = table_lgi();
+	double * __restrict__ w_re = rt->w_re;
+	double * __restrict__ w_im = rt->w_im;
+
+	#pragma omp simd
+	for (int j=1;j <= Nmax;j++) {
+		double s, c;
+		rs_sincos(t*lgi[TAB_STRIDE*j], &s, &c);
+		w_re[j] =  isq[TAB_STRIDE*j] * c;
+		w_im[j] = -isq[TAB_STRIDE*j] * s;
+	}
+}
+
+// Adds the terms jb..je (j<=Ns[i]) to W of the m samples of the block, moving
+// w_j from one sample to the next. The terms stay in L1 for the whole block.
+SIMD_CLONES void rotor_run(rotor_t *rt, const int jb, const int je, const ui64 m)
+{
+	double * __restrict__ w_re = rt->w_re;
+	double * __restrict__ w_im = rt->w_im;
+	const double * __restrict__ r_re = rt->r_re;
+	const double * __restrict__ r_im = rt->r_im;
+
+	for (ui64 i = 0; i < m; i++)
+	{
+		const int N = (rt->Ns[i] < je) ? rt->Ns[i] : je;
+		double a = 0.0;
+		double b = 0.0;
+		#pragma omp simd reduction(+:a,b)
+		for (int j=jb;j <= N;j++) {
+			const double x = w_re[j];
+			const double y = w_im[j];
+			a += x;
+			b += y;
+			w_re[j] = x*r_re[j] - y*r_im[j];
+			w_im[j] = x*r_im[j] + y*r_re[j];
+		}
+		#pragma omp simd
+		for (int j=(N < jb ? jb : N+1);j <= je;j++) {
+			const double x = w_re[j];
+			const double y = w_im[j];
+			w_re[j] = x*r_re[j] - y*r_im[j];
+			w_im[j] = x*r_im[j] + y*r_re[j];
+		}
+		rt->W_re[i] += a;
+		rt->W_im[i] += b;
+	}
+}
+
+void Z_rotor(rotor_t *rt, const double t0, const double h, const ui64 n, const double *theta_t, double *out)
+{
+	const double two_pi = 2.0 * 3.1415926535897932385;
+
+	for (ui64 i0 = 0; i0 < n; i0 += ROTOR_SYNC)
+	{
+		const ui64 m = (n - i0 < ROTOR_SYNC) ? n - i0 : ROTOR_SYNC;
+		const double ts = t0 + (double)i0*h;
+		const int Nmax = (int)sqrt((ts + (double)(m-1)*h)/two_pi);
+		rotor_reserve(rt, Nmax, h);
+		rotor_sync(rt, ts, Nmax);
+
+		for (ui64 i = 0; i < m; i += R_BLOCK)
+		{
+			const ui64 b = (m - i < R_BLOCK) ? m - i : R_BLOCK;
+			double t[R_BLOCK];
+			for (ui64 k = 0; k < b; k++)
+				t[k] = ts + (double)(i+k)*h;
+			R_batch(t, rt->Ns + i, rt->R + i, b);
+		}
+		for (ui64 i = 0; i < m; i++)
+		{
+			rt->W_re[i] = 0.0;
+			rt->W_im[i] = 0.0;
+		}
+		for (int jb = 1; jb <= Nmax; jb += ROTOR_TERMS)
+		{
+			const int je = (jb + ROTOR_TERMS - 1 < Nmax) ? jb + ROTOR_TERMS - 1 : Nmax;
+			rotor_run(rt, jb, je, m);
+		}
+		for (ui64 i = 0; i < m; i++)
+		{
+			const double tt = theta_t[i0+i];
+			out[i0+i] = 2.0*(cos(tt)*rt->W_re[i] - sin(tt)*rt->W_im[i]) + rt->R[i];
+		}
+	}
+}
+
+// Same samples as ENGINE_DIRECT : out[i] = Z(STEP*(first+i) + LOWER), theta_t[i] their theta
+void Z_tile(const double LOWER, const double STEP, const ui64 first, const ui64 n, const double *theta_t, double *out)
+{
+	ui64 i = 0;
+	for (; i + TILE_K <= n; i += TILE_K)
+	{
+		double t[TILE_K], tt[TILE_K], R[TILE_K], ZZ[TILE_K];
+		int    Ns[TILE_K];
+		for (int k = 0; k < TILE_K; k++)
+		{
+			t[k] = STEP*(first+i+k) + LOWER;
+			tt[k] = theta_t[i+k];
+		}
+		R_batch(t, Ns, R, TILE_K);
+		main_sum_tile(t, tt, Ns, ZZ);
+		for (int k = 0; k < TILE_K; k++)
+			out[i+k] = 2.0*ZZ[k] + R[k];
+	}
+	for (; i < n; i++)
+		out[i] = Z_theta(STEP*(first+i) + LOWER, theta_t[i]);
+}
+
+/*************************************************************************
+	Odlyzko-Schonhage multi-evaluation
+
+	On a block t_k = t0 + k*h, k < M, the main sum is
+		F(t_k) = sum_{j<=N} a_j e^{-i k x_j},  a_j = j^{-1/2} e^{-i t0 log j},  x_j = h log j mod 2pi
+	i.e. a non uniform DFT of the N terms on M integer frequencies. It is
+	computed as a type 1 NUFFT (Greengard-Lee 2004) :
+	  - each term is spread on the 2*OS_SPREAD nearest points of a uniform
+	    grid of OS_OVERSAMPLE*M points with a gaussian (band-limited interpolation),
+	  - one FFT of the grid,
+	  - the gaussian is divided out of the M frequencies we need.
+	Cost per block : O(N*OS_SPREAD + M log M) instead of O(N*M), so about
+	N*OS_SPREAD/M + log M per sample. M is the block of Z_samples, at most
+	SAMPLE_BLOCK : the cost per sample stays O(N), a factor of about
+	M/OS_SPREAD below the direct sums, it does not become the N^eps of
+	Odlyzko-Schonhage, which needs blocks of about N samples (M growing
+	with N). OS_SPREAD=12 with an oversampling of 2
+	gives a relative error around 1e-13 of sum j^{-1/2}.
+	The few terms N(t0) < j <= N(t_k) of the block are added directly.
+	Below OS_MIN_TERMS terms the direct kernels are faster.
+*************************************************************************/
+
+#ifndef OS_SPREAD
+#define OS_SPREAD 12
+#endif
+#define OS_OVERSAMPLE 2
+
+#ifndef OS_MIN_TERMS
+#define OS_MIN_TERMS 64
+#endif
+
+void os_plan(os_t *os, const int M)
+{
+	const double pi = 3.1415926535897932385;
+	if (os->M == M)
+		return;
+	const int Mr = OS_OVERSAMPLE*M;
+	const double dxi = 2.0*pi/Mr;
+	os->M = M;
+	os->tau = pi*OS_SPREAD/((double)M*M*OS_OVERSAMPLE*(OS_OVERSAMPLE-0.5));
+	os->grid    = (double *)realloc(os->grid, 2*Mr*sizeof(double));
+	os->twiddle = (double *)realloc(os->twiddle, Mr*sizeof(double));
+	os->E3      = (double *)realloc(os->E3, 2*OS_SPREAD*sizeof(double));
+	os->decon   = (double *)realloc(os->decon, M*sizeof(double));
+	os->F       = (double *)realloc(os->F, 2*M*sizeof(double));
+	for (int k = 0; k < Mr/2; k++)
+	{
+		os->twiddle[2*k]   =  cos(2.0*pi*k/Mr);
+		os->twiddle[2*k+1] = -sin(2.0*pi*k/Mr);
+	}
+	for (int l = -OS_SPREAD+1; l <= OS_SPREAD; l++)
+		os->E3[l+OS_SPREAD-1] = exp(-(l*dxi)*(l*dxi)/(4.0*os->tau));
+	for (int k = -M/2; k < M/2; k++)
+		os->decon[k+M/2] = sqrt(pi/os->tau)*exp((double)k*k*os->tau)/Mr;
+}
+
+// In place radix 2 forward FFT, X[q] = sum_m a[m] e^{-2 i pi qm/n}
+void fft(double *a, const int n, const double *twiddle)
+{
+	for (int i = 1, j = 0; i < n; i++)
+	{
+		int bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		if (i < j)
+		{
+			const double re = a[2*i], im = a[2*i+1];
+			a[2*i] = a[2*j]; a[2*i+1] = a[2*j+1];
+			a[2*j] = re;     a[2*j+1] = im;
+		}
+	}
+	for (int len = 2; len <= n; len <<= 1)
+	{
+		const int half = len >> 1;
+		const int stride = n/len;
+		for (int i = 0; i < n; i += len)
+			for (int k = 0; k < half; k++)
+			{
+				const double w_re = twiddle[2*k*stride];
+				const double w_im = twiddle[2*k*stride+1];
+				double *u = a + 2*(i+k);
+				double *v = a + 2*(i+k+half);
+				const double x = v[0]*w_re - v[1]*w_im;
+				const double y = v[0]*w_im + v[1]*w_re;
+				v[0] = u[0] - x;
+				v[1] = u[1] - y;
+				u[0] += x;
+				u[1] += y;
+			}
+	}
+}
+
+// F[k] = sum_{j<=N} j^{-1/2} e^{-i (t0 + k h) log j} for k < M
+void os_main_sums(os_t *os, const double t0, const double h, const int N)
+{
+	const double two_pi = 2.0 * 3.1415926535897932385;
+	const int M  = os->M;
+	const int Mr = OS_OVERSAMPLE*M;
+	const double dxi = two_pi/Mr;
+	double *grid = os->grid;
+	const double *isq = table_isq();
+	const double *lgi = table_lgi();
+
+	memset(grid, 0, 2*Mr*sizeof(double));
+	for (int j=1;j <= N;j++)
+	{
+		double x = fmod(h*lgi[TAB_STRIDE*j], two_pi);
+		// output k is the centered frequency k-M/2 : fold e^{-i (M/2) x_j} in the coefficient
+		double s, c;
+		rs_sincos(t0*lgi[TAB_STRIDE*j] + 0.5*M*x, &s, &c);
+		const double a_re =  isq[TAB_STRIDE*j]*c;
+		const double a_im = -isq[TAB_STRIDE*j]*s;
+
+		// fast gaussian gridding around the grid point m0 just below x
+		const int m0 = (int)(x/dxi);
+		const double d = x - m0*dxi;
+		const double E1 = exp(-d*d/(4.0*os->tau));
+		const double E2 = exp(d*dxi/(2.0*os->tau));
+		double E2l = E1*pow(E2, -OS_SPREAD+1);
+		for (int l = -OS_SPREAD+1; l <= OS_SPREAD; l++)
+		{
+			const double g = E2l*os->E3[l+OS_SPREAD-1];
+			const int m = (m0 + l) & (Mr-1);
+			grid[2*m]   += g*a_re;
+			grid[2*m+1] += g*a_im;
+			E2l *= E2;
+		}
+	}
+	fft(grid, Mr, os->twiddle);
+	for (int k = -M/2; k < M/2; k++)
+	{
+		const int q = k & (Mr-1);
+		os->F[2*(k+M/2)]   = grid[2*q]  *os->decon[k+M/2];
+		os->F[2*(k+M/2)+1] = grid[2*q+1]*os->decon[k+M/2];
+	}
+}
+
+void Z_os(os_t *os, const double LOWER, const double STEP, const ui64 first, const ui64 n, const double *theta_t, double *out)
+{
+	const double two_pi = 2.0 * 3.1415926535897932385;
+	const double t0 = STEP*first + LOWER;
+	const int Nmin = (int)sqrt(t0/two_pi);
+	if (Nmin < OS_MIN_TERMS)
+	{
+		Z_tile(LOWER, STEP, first, n, theta_t, out);
+		return;
+	}
+	int M = 2;
+	while ((ui64)M < n)
+		M <<= 1;
+	os_plan(os, M);
+	os_main_sums(os, t0, STEP, Nmin);
+	const double *isq = table_isq();
+	const double *lgi = table_lgi();
+
+	for (ui64 k0 = 0; k0 < n; k0 += R_BLOCK)
+	{
+		const ui64 b = (n - k0 < R_BLOCK) ? n - k0 : R_BLOCK;
+		double t[R_BLOCK], R[R_BLOCK];
+		int    Ns[R_BLOCK];
+		for (ui64 k = 0; k < b; k++)
+			t[k] = t0 + (double)(k0+k)*STEP;
+		R_batch(t, Ns, R, b);
+		for (ui64 k = 0; k < b; k++)
+		{
+			const double tt = theta_t[k0+k];
+			double ZZ = cos(tt)*os->F[2*(k0+k)] - sin(tt)*os->F[2*(k0+k)+1];
+			for (int j=Nmin+1;j <= Ns[k];j++)
+				ZZ += isq[TAB_STRIDE*j] * rs_cos(tt - t[k]*lgi[TAB_STRIDE*j]);
+			out[k0+k] = 2.0*ZZ + R[k];
+		}
+	}
+}
+
+/*************************************************************************
+	ENGINE_TAYLOR : local Taylor expansion of the main sum
+
+	Around a center t0, with d = t-t0, c = log(Nw)/2 and L_j = log j - c
+		sum_{j<=Nw} j^{-1/2} e^{-i t log j} = e^{-i d c} sum_k A_k (-i d)^k
+		A_k = 1/k! sum_{j<=Nw} j^{-1/2} L_j^k e^{-i t0 log j}
+	The TAYLOR_K moments A_k cost one sincos and TAYLOR_K complex
+	multiply-adds per term, once per window, then a sample costs
+	O(TAYLOR_K) plus theta() and the remainder. |L_j| <= c, so the terms
+	left out are below (|d| c)^K/K! e^{|d| c} 2 sqrt(Nw) : the half width
+	of the window is the largest |d| keeping this under TAYLOR_EPS. The
+	terms past Nw (N grows inside the window) are added directly. Windows
+	of less than TAYLOR_MIN_SAMPLES samples are left to Z_tile.
+*************************************************************************/
+
+#ifndef TAYLOR_K
+#define TAYLOR_K 24
+#endif
+
+#ifndef TAYLOR_EPS
+#define TAYLOR_EPS 1e-9
+#endif
+
+#ifndef TAYLOR_MIN_SAMPLES
+#define TAYLOR_MIN_SAMPLES 8
+#endif
+
+#ifndef TAYLOR_MIN_TERMS
+#define TAYLOR_MIN_TERMS 64
+#endif
+
+#define TAYLOR_LANES 8
+
+// Largest |d| of a window of Nw terms
+double taylor_radius(const int Nw)
+{
+	const double c = 0.5*log((double)Nw);
+	const double w = 2.0*sqrt((double)Nw);
+	double fact = 1.0;
+	for (int k = 2; k <= TAYLOR_K; k++)
+		fact *= k;
+	double x = pow(TAYLOR_EPS*fact/w, 1.0/TAYLOR_K);
+	while (pow(x, TAYLOR_K)/fact*exp(x)*w > TAYLOR_EPS)
+		x *= 0.95;
+	return x/c;
+}
+
+// A_k of the window centered on t0, TAYLOR_LANES terms at once
+SIMD_CLONES void taylor_moments(const double t0, const int Nw, const double c, double *A_re, double *A_im)
+{
+	const double *isq = table_isq();
+	const double *lgi = table_lgi();
+	double acc_re[TAYLOR_K][TAYLOR_LANES];
+	double acc_im[TAYLOR_K][TAYLOR_LANES];
+	memset(acc_re, 0, sizeof(acc_re));
+	memset(acc_im, 0, sizeof(acc_im));
+
+	for (int jb = 1; jb <= Nw; jb += TAYLOR_LANES)
+	{
+		double p_re[TAYLOR_LANES], p_im[TAYLOR_LANES], L[TAYLOR_LANES];
+		#pragma omp simd
+		for (int l = 0; l < TAYLOR_LANES; l++)
+		{
+			// lanes past Nw read the term 1 with a zero weight
+			const int j = (jb + l <= Nw) ? jb + l : 1;
+			const double a = (jb + l <= Nw) ? isq[TAB_STRIDE*j] : 0.0;
+			double s, co;
+			rs_sincos(t0*lgi[TAB_STRIDE*j], &s, &co);
+			p_re[l] =  a*co;
+			p_im[l] = -a*s;
+			L[l] = lgi[TAB_STRIDE*j] - c;
+		}
+		for (int k = 0; k < TAYLOR_K; k++)
+		{
+			#pragma omp simd
+			for (int l = 0; l < TAYLOR_LANES; l++)
+			{
+				acc_re[k][l] += p_re[l];
+				acc_im[k][l] += p_im[l];
+				p_re[l] *= L[l];
+				p_im[l] *= L[l];
+			}
+		}
+	}
+	double fact = 1.0;
+	for (int k = 0; k < TAYLOR_K; k++)
+	{
+		double re = 0.0, im = 0.0;
+		for (int l = 0; l < TAYLOR_LANES; l++)
+		{
+			re += acc_re[k][l];
+			im += acc_im[k][l];
+		}
+		fact *= (k > 0) ? k : 1;
+		A_re[k] = re/fact;
+		A_im[k] = im/fact;
+	}
+}
+
+// Same samples as ENGINE_DIRECT : out[i] = Z(STEP*(first+i) + LOWER)
+void Z_taylor(const double LOWER, const double STEP, const ui64 first, const ui64 n, const double *theta_t, double *out)
+{
+	const double two_pi = 2.0 * 3.1415926535897932385;
+	const double *isq = table_isq();
+	const double *lgi = table_lgi();
+	double A_re[TAYLOR_K], A_im[TAYLOR_K];
+	double t[R_BLOCK], R[R_BLOCK];
+	int    Ns[R_BLOCK];
+	ui64 i = 0;
+	while (i < n)
+	{
+		const double ta = STEP*(first+i) + LOWER;
+		const int Nw = (int)sqrt(ta/two_pi);
+		ui64 m = 0;
+		if (Nw >= TAYLOR_MIN_TERMS)
+			m = (ui64)(2.0*taylor_radius(Nw)/STEP) + 1;
+		if (m > n - i)
+			m = n - i;
+		if (m < TAYLOR_MIN_SAMPLES)
+		{
+			// the windows only get shorter with t
+			Z_tile(LOWER, STEP, first+i, n-i, theta_t+i, out+i);
+			return;
+		}
+		const double t0 = STEP*((double)(first+i) + 0.5*(double)(m-1)) + LOWER;
+		const double c = 0.5*log((double)Nw);
+		taylor_moments(t0, Nw, c, A_re, A_im);
+
+		for (ui64 k = 0; k < m; k++)
+		{
+			if (k % R_BLOCK == 0)
+			{
+				const ui64 b = (m - k < R_BLOCK) ? m - k : R_BLOCK;
+				for (ui64 l = 0; l < b; l++)
+					t[l] = STEP*(first+i+k+l) + LOWER;
+				R_batch(t, Ns, R, b);
+			}
+			const ui64 kb = k % R_BLOCK;
+			const double d = t[kb] - t0;
+			// S = sum_k A_k (-i d)^k by Horner, (x + iy)(-i d) = y d - i x d
+			double S_re = A_re[TAYLOR_K-1], S_im = A_im[TAYLOR_K-1];
+			for (int q = TAYLOR_K - 2; q >= 0; q--)
+			{
+				const double r = S_im*d + A_re[q];
+				S_im = A_im[q] - S_re*d;
+				S_re = r;
+			}
+			const double tt = theta_t[i+k];
+			const double phi = tt - d*c;
+			double ZZ = cos(phi)*S_re - sin(phi)*S_im;
+			for (int j = Nw+1; j <= Ns[kb]; j++)
+				ZZ += isq[TAB_STRIDE*j] * rs_cos(tt - t[kb]*lgi[TAB_STRIDE*j]);
+			out[i+k] = 2.0*ZZ + R[kb];
+		}
+		i += m;
+	}
+}
+
+/*************************************************************************
+	ENGINE_OFFSET : base plus offset phases
+
+	At t = 1e11 the phase t log j is around 3e12 : the double product and
+	the rounding of log_int[j] itself leave about 1e-3 rad on a term, and
+	theta(t) as much. On a block of samples t = T0 + d, T0 log j mod 2pi
+	is computed once per term in long double (offset_reserve) and
+	theta(t) mod 2pi once per sample (theta_mod), so a term only needs
+	d log j, small with a small rounding :
+		sum_j j^-1/2 cos(theta(t) mod 2pi - (T0 log j mod 2pi) - d log j)
+	The samples go by tiles of TILE_K, the three streams are loaded once
+	per tile.
+*************************************************************************/
+
+// ph[j] = T0 log j mod 2pi for j <= N
+void offset_reserve(offset_t *of, const double T0, const int N)
+{
+	const long double two_pi = 2.0L*3.14159265358979323846264338327950288L;
+	if (N+1 > of->size)
+	{
+		of->size = 2*(N+1);
+		of->ph = (double *)realloc(of->ph, of->size*sizeof(double));
+	}
+	if (T0 != of->T0)
+	{
+		of->T0 = T0;
+		of->N = 0;
+	}
+	for (int j = of->N+1; j <= N; j++)
+		of->ph[j] = (double)fmodl((long double)T0*logl((long double)j), two_pi);
+	if (N > of->N)
+		of->N = N;
+}
+
+// Main sums of the samples T0 + d[k], tm[k] = theta mod 2pi
+SIMD_CLONES void offset_tile(const double *ph, const double *d, const double *tm, const int *Ns, double *ZZ)
+{
+	const double *isq = table_isq();
+	const double *lgi = table_lgi();
+	const int Nmin = tile_min(Ns);
+	double acc[TILE_K];
+	for (int k = 0; k < TILE_K; k++)
+		acc[k] = 0.0;
+
+	#pragma omp simd reduction(+:acc[:TILE_K])
+	for (int j=1;j <= Nmin;j++) {
+		const double a = isq[TAB_STRIDE*j];
+		const double l = lgi[TAB_STRIDE*j];
+		const double p = ph[j];
+		for (int k = 0; k < TILE_K; k++)
+			acc[k] += a * rs_cos((tm[k] - p) - d[k]*l);
+	}
+	for (int k = 0; k < TILE_K; k++) {
+		for (int j=Nmin+1;j <= Ns[k];j++)
+			acc[k] += isq[TAB_STRIDE*j] * rs_cos((tm[k] - ph[j]) - d[k]*lgi[TAB_STRIDE*j]);
+		ZZ[k] = acc[k];
+	}
+}
+
+// Same samples as ENGINE_DIRECT : out[i] = Z(STEP*(first+i) + LOWER)
+void Z_offset(offset_t *of, const double LOWER, const double STEP, const ui64 first, const ui64 n, double *out)
+{
+	const double two_pi = 2.0 * 3.1415926535897932385;
+	const double T0 = STEP*first + LOWER;
+	offset_reserve(of, T0, (int)sqrt((STEP*(first+n-1) + LOWER)/two_pi));
+
+	for (ui64 i = 0; i < n; i += TILE_K)
+	{
+		double t[TILE_K], d[TILE_K], tm[TILE_K], R[TILE_K], ZZ[TILE_K];
+		int    Ns[TILE_K];
+		for (int k = 0; k < TILE_K; k++)
+		{
+			// a last partial tile repeats its last sample
+			const ui64 s = (i + k < n) ? i + k : n - 1;
+			t[k]  = STEP*(first+s) + LOWER;
+			d[k]  = t[k] - T0;
+			tm[k] = theta_mod(T0, d[k]);
+		}
+		R_batch(t, Ns, R, TILE_K);
+		offset_tile(of->ph, d, tm, Ns, ZZ);
+		for (int k = 0; k < TILE_K && i + k < n; k++)
+			out[i+k] = 2.0*ZZ[k] + R[k];
+	}
+}
+
+void workspace_init(workspace_t *ws)
+{
+	memset(ws, 0, sizeof(*ws));
+	ws->zbuf = (double *)malloc(SAMPLE_BLOCK*sizeof(double));
+	ws->tbuf = (double *)malloc(SAMPLE_BLOCK*sizeof(double));
+	ws->ttbuf = (double *)malloc(SAMPLE_BLOCK*sizeof(double));
+	ws->rotor.Ns   = (int *)malloc(ROTOR_SYNC*sizeof(int));
+	ws->rotor.R    = (double *)malloc(ROTOR_SYNC*sizeof(double));
+	ws->rotor.W_re = (double *)malloc(ROTOR_SYNC*sizeof(double));
+	ws->rotor.W_im = (double *)malloc(ROTOR_SYNC*sizeof(double));
+}
+
+void workspace_free(workspace_t *ws)
+{
+	free(ws->rotor.w_re);
+	free(ws->rotor.w_im);
+	free(ws->rotor.r_re);
+	free(ws->rotor.r_im);
+	free(ws->rotor.Ns);
+	free(ws->rotor.R);
+	free(ws->rotor.W_re);
+	free(ws->rotor.W_im);
+	free(ws->os.grid);
+	free(ws->os.twiddle);
+	free(ws->os.E3);
+	free(ws->os.decon);
+	free(ws->os.F);
+	free(ws->offset.ph);
+	free(ws->zbuf);
+	free(ws->tbuf);
+	free(ws->ttbuf);
+}
+
+// out[i] = Z(LOWER + STEP*(first+i)) for i < n
+void Z_samples(workspace_t *ws, const double LOWER, const double STEP, const ui64 first, const ui64 n, double *out)
+{
+	if (engine != ENGINE_OFFSET)
+	{
+		// the t of the engine
+		if (engine == ENGINE_ROTOR || engine == ENGINE_OS)
+			for (ui64 i = 0; i < n; i++)
+				ws->tbuf[i] = STEP*first + LOWER + (double)i*STEP;
+		else
+			for (ui64 i = 0; i < n; i++)
+				ws->tbuf[i] = STEP*(first+i) + LOWER;
+		theta_run(ws->tbuf, ws->ttbuf, n);
+	}
+	switch (engine)
+	{
+	case ENGINE_ROTOR:
+		Z_rotor(&ws->rotor, STEP*first + LOWER, STEP, n, ws->ttbuf, out);
+		break;
+	case ENGINE_TILE:
+		Z_tile(LOWER, STEP, first, n, ws->ttbuf, out);
+		break;
+	case ENGINE_OS:
+		Z_os(&ws->os, LOWER, STEP, first, n, ws->ttbuf, out);
+		break;
+	case ENGINE_TAYLOR:
+		Z_taylor(LOWER, STEP, first, n, ws->ttbuf, out);
+		break;
+	case ENGINE_OFFSET:
+		Z_offset(&ws->offset, LOWER, STEP, first, n, out);
+		break;
+	default:
+		for (ui64 i = 0; i < n; i++)
+			out[i] = Z_theta(ws->tbuf[i], ws->ttbuf[i]);
+		break;
+	}
+}
+
+/*
+	Adaptive refinement of the coarse samples (SAMPLING_ADAPTIVE)
+
+	Between two zeros |Z| goes up and down once, two zeros hidden between
+	two samples of the same sign show up as a local minimum of |Z| inside
+	a run of samples of the same sign. Such a dip is refined : the
+	midpoints on both sides are evaluated and the search goes on around
+	the smallest |Z|, up to ADAPT_DEPTH times, until a sign change shows.
+	A window of ADAPT_WINDOW intervals with less sign changes than
+	(theta(b) - theta(a))/pi - ADAPT_SLACK also gets one midpoint in every
+	interval without sign change, a midpoint below both ends is a dip and
+	is searched the same way (close pairs inside one interval).
+*/
+
+#ifndef ADAPT_DEPTH
+#define ADAPT_DEPTH 6
+#endif
+
+#ifndef ADAPT_WINDOW
+#define ADAPT_WINDOW 64
+#endif
+
+#ifndef ADAPT_SLACK
+#define ADAPT_SLACK 1.0
+#endif
+
+static inline double sign_change(const double a, const double b)
+{
+	return (signbit(a) != signbit(b));
+}
+
+// Sign changes found around the dip |zm| < |za|, |zb| (za, zm, zb of the same sign)
+double adapt_dip(const double ta, const double za, const double tm, const double zm,
+		const double tb, const double zb, const int depth, double *evals)
+{
+	if (depth == 0)
+		return 0.0;
+	const double t1 = 0.5*(ta + tm);
+	const double t2 = 0.5*(tm + tb);
+	const double z1 = Z(t1);
+	const double z2 = Z(t2);
+	*evals += 2.0;
+	const double c = sign_change(za, z1) + sign_change(z1, zm) + sign_change(zm, z2) + sign_change(z2, zb);
+	if (c > 0.0)
+		return c;
+	if (fabs(z1) < fabs(zm) && fabs(z1) <= fabs(z2))
+		return adapt_dip(ta, za, t1, z1, tm, zm, depth - 1, evals);
+	if (fabs(z2) < fabs(zm))
+		return adapt_dip(tm, zm, t2, z2, tb, zb, depth - 1, evals);
+	return adapt_dip(t1, z1, tm, zm, t2, z2, depth - 1, evals);
+}
+
+/*
+	Sign changes of the block z[0..n) of samples first..first+n-1,
+	prev is the value before first. With prev_ok prev is the sample
+	first-1, otherwise (chunk seams) the interval [prev, z[0]] is left to
+	the caller.
+	The dip at k refines [first+k-1, first+k+1]. The edge dips take the
+	true neighbouring samples, t_prev (sample first-1) and t_next (sample
+	first+n), from sample_t() : on the density grid the next block has
+	its own step, the cells of this one are not extended past its edges.
+	With extend the dip at the last sample reaches t_next (znext,
+	evaluated on demand). At chunk seams the two edge dips are done by
+	adapt_seam() : so that a block gives the same count whether its edges
+	are chunk seams or not, the edge dips and the entry crossing are kept
+	out of the window test and the window refinement leaves the first two
+	and the last interval alone.
+*/
+double adapt_block(const double LOWER, const double STEP, const ui64 first, const ui64 n,
+		const double *z, const double prev, const int prev_ok, const int extend,
+		const double t_prev, const double t_next, double *evals)
+{
+	const double pi = 3.1415926535897932385;
+	double count = 0.0;
+	double edge = 0.0;	// entry crossing and edge dips
+	double znext = 0.0;
+	int    have_next = 0;
+	ui64   dip_end = 0;	// intervals up to dip_end were searched by a dip
+
+	for (ui64 w = 0; w < n; w += ADAPT_WINDOW)
+	{
+		const ui64 m = (n - w < ADAPT_WINDOW) ? n - w : ADAPT_WINDOW;
+		double found = 0.0;
+		double extra = 0.0;
+		for (ui64 k = w; k < w + m; k++)
+		{
+			const double zp = (k > 0) ? z[k-1] : prev;
+			if (k == 0)
+				edge += prev_ok ? sign_change(zp, z[0]) : 0.0;
+			else
+				found += sign_change(zp, z[k]);
+			// dip at k
+			if ((k == 0 && !prev_ok) || sign_change(zp, z[k]) || fabs(z[k]) >= fabs(zp))
+				continue;
+			if (k + 1 == n && !extend)
+				continue;
+			if (k + 1 == n && !have_next)
+			{
+				znext = Z(t_next);
+				*evals += 1.0;
+				have_next = 1;
+			}
+			const double zb = (k + 1 < n) ? z[k+1] : znext;
+			if (!sign_change(z[k], zb) && fabs(z[k]) <= fabs(zb))
+			{
+				const double ta = (k > 0) ? STEP*((double)first+k-1.0) + LOWER : t_prev;
+				const double tb = (k + 1 < n) ? STEP*(first+k+1) + LOWER : t_next;
+				const double c = adapt_dip(ta, zp, STEP*(first+k) + LOWER, z[k], tb, zb, ADAPT_DEPTH, evals);
+				if (k == 0 || k + 1 == n)
+					edge += c;
+				else
+				{
+					extra += c;
+					dip_end = k + 1;
+				}
+			}
+		}
+		const double ta = STEP*(first+w) + LOWER;
+		const double tb = STEP*(first+w+m-1) + LOWER;
+		if (found + extra < (theta(tb) - theta(ta))/pi - ADAPT_SLACK)
+		{
+			const ui64 kb = (w > 2) ? w : 2;
+			const ui64 ke = (w + m < n - 1) ? w + m : n - 1;
+			for (ui64 k = kb; k < ke; k++)
+			{
+				if (k <= dip_end || sign_change(z[k-1], z[k]))
+					continue;
+				const double tm = STEP*((double)(first+k) - 0.5) + LOWER;
+				const double zm = Z(tm);
+				*evals += 1.0;
+				if (sign_change(z[k], zm))
+					extra += 2.0;
+				else if (fabs(zm) < fabs(z[k-1]) && fabs(zm) < fabs(z[k]))
+					extra += adapt_dip(STEP*((double)(first+k) - 1.0) + LOWER, z[k-1], tm, zm,
+							STEP*(first+k) + LOWER, z[k], ADAPT_DEPTH - 1, evals);
+			}
+		}
+		count += found + extra;
+	}
+	return count + edge;
+}
+
+/*
+	Sample grids
+
+	GRID_UNIFORM : sample i is LOWER + STEP*i (SAMP samples per unit of t).
+	GRID_DENSITY : SAMP samples per mean zero spacing 2pi/log(t/2pi). The
+	grid is uniform in theta(t)/pi : block b of SAMPLE_BLOCK samples starts
+	at grid_T[b] = theta^-1(pi (u0 + b SAMPLE_BLOCK/SAMP)) and has the
+	constant step grid_H[b] inside, so the engines still see uniform steps.
+	Every block is defined on its own, any split of the sample indices
+	between threads sees the same grid.
+*/
+
+typedef enum { GRID_UNIFORM, GRID_DENSITY } grid_t;
+grid_t grid = GRID_UNIFORM;
+double *grid_T = NULL;
+double *grid_H = NULL;
+double  grid_hi = HUGE_VAL;	// t of the last sample
+
+// t of the sample i, never past the last one
+double sample_t(const double LOWER, const double STEP, const ui64 i)
+{
+	double t = STEP*i + LOWER;
+	if (grid == GRID_DENSITY)
+	{
+		const ui64 b = i/SAMPLE_BLOCK;
+		t = grid_T[b] + grid_H[b]*(double)(i - b*SAMPLE_BLOCK);
+	}
+	return (t < grid_hi) ? t : grid_hi;
+}
+
+/*
+	Cost model : a sample at t costs N(t) = sqrt(t/2pi) terms plus
+	COST_FIXED (theta, remainder). With -e os a sample costs about
+	N(t) OS_SPREAD/SAMPLE_BLOCK, still proportional to N(t). cost_bounds splits the samples [0, n)
+	in parts slices of equal cost, slice k is the samples bound[k] to
+	bound[k+1] included, the slices share their end samples.
+	The cumulative cost is tabulated on COST_PIECES pieces of the index
+	range and inverted by linear interpolation.
+*/
+
+#ifndef COST_FIXED
+#define COST_FIXED 16.0
+#endif
+
+#ifndef COST_PIECES
+#define COST_PIECES 16384
+#endif
+
+void cost_bounds(const double LOWER, const double STEP, const ui64 n, const ui64 parts, ui64 *bound)
+{
+	const double two_pi = 2.0 * 3.1415926535897932385;
+	const ui64 last = (n > 0) ? n - 1 : 0;
+	const ui64 P = (last < COST_PIECES) ? last : COST_PIECES;
+
+	bound[0] = 0;
+	for (ui64 k = 1; k <= parts; k++)
+		bound[k] = last;
+	if (P == 0)
+		return;
+
+	double *c = (double *)malloc((P + 1)*sizeof(double));
+	c[0] = 0.0;
+	for (ui64 p = 0; p < P; p++)
+	{
+		const ui64 i0 = p*last/P;
+		const ui64 i1 = (p + 1)*last/P;
+		const double t = sample_t(LOWER, STEP, (i0 + i1)/2);
+		c[p+1] = c[p] + (double)(i1 - i0)*(sqrt(t/two_pi) + COST_FIXED);
+	}
+	ui64 p = 0;
+	for (ui64 k = 1; k < parts; k++)
+	{
+		const double target = c[P]*(double)k/(double)parts;
+		while (p + 1 < P && c[p+1] < target)
+			p++;
+		const ui64 i0 = p*last/P;
+		const ui64 i1 = (p + 1)*last/P;
+		const double f = (c[p+1] > c[p]) ? (target - c[p])/(c[p+1] - c[p]) : 0.0;
+		bound[k] = i0 + (ui64)(f*(double)(i1 - i0) + 0.5);
+		if (bound[k] < bound[k-1])
+			bound[k] = bound[k-1];
+	}
+	free(c);
+}
+
+// Result of a chunk : its sign changes and the values of its first and last two samples
+typedef struct chunk_result_s {
+	double count;
+	double z_first, z_second;
+	double z_penult, z_last;
+} chunk_result_t;
+
+/*
+	Sign changes over the samples [first, end), first is a multiple of
+	SAMPLE_BLOCK. The crossing with the samples before first (and the
+	adaptive refinement around it) is left to the caller.
+*/
+double count_chunk(workspace_t *ws, const double LOWER, const double STEP, const ui64 first, const ui64 end,
+		chunk_result_t *r)
+{
+	double count = 0.0;
+	double prev = 0.0;
+	for (ui64 i = first; i < end; )
+	{
+		ui64 n = (end - i < SAMPLE_BLOCK) ? end - i : SAMPLE_BLOCK;
+		double lo = LOWER, st = STEP;
+		ui64   f = i;
+		if (grid == GRID_DENSITY)
+		{
+			// stay inside the grid block of i, in its own coordinates
+			const ui64 b = i/SAMPLE_BLOCK;
+			f  = i - b*SAMPLE_BLOCK;
+			lo = grid_T[b];
+			st = grid_H[b];
+			if (n > SAMPLE_BLOCK - f)
+				n = SAMPLE_BLOCK - f;
+		}
+		Z_samples(ws, lo, st, f, n, ws->zbuf);
+		if (i == first)
+		{
+			r->z_first  = ws->zbuf[0];
+			r->z_second = ws->zbuf[(n > 1) ? 1 : 0];
+			prev = ws->zbuf[0];
+		}
+		else if (i == first + 1)
+			r->z_second = ws->zbuf[0];
+		r->z_penult = (n > 1) ? ws->zbuf[n-2] : prev;
+		if (sampling == SAMPLING_ADAPTIVE)
+			count += adapt_block(lo, st, f, n, ws->zbuf, prev, i > first, i + n < end,
+					(i > 0) ? sample_t(LOWER, STEP, i - 1) : LOWER, sample_t(LOWER, STEP, i + n), &ws->refined);
+		else
+		{
+			for (ui64 k = 0; k < n; k++)
+			{
+				const double zout = ws->zbuf[k];
+				count += (signbit(zout) != signbit(prev));
+				prev = zout;
+			}
+		}
+		prev = ws->zbuf[n-1];
+		i += n;
+	}
+	r->z_last = prev;
+	r->count = count;
+	return count;
+}
+
+/*
+	Adaptive refinement around the seam before the sample e (a multiple of
+	SAMPLE_BLOCK) between the chunks L and R : the dips at e-1 and at e,
+	exactly as adapt_block does them inside a chunk, on the true samples
+*/
+double adapt_seam(const double LOWER, const double STEP, const ui64 e,
+		const chunk_result_t *L, const chunk_result_t *R, double *evals)
+{
+	double c = 0.0;
+	const double t0 = sample_t(LOWER, STEP, e - 2);
+	const double t1 = sample_t(LOWER, STEP, e - 1);
+	const double t2 = sample_t(LOWER, STEP, e);
+	const double t3 = sample_t(LOWER, STEP, e + 1);
+	if (!sign_change(L->z_penult, L->z_last) && fabs(L->z_last) < fabs(L->z_penult))
+	{
+		const double zb = Z(t2);
+		*evals += 1.0;
+		if (!sign_change(L->z_last, zb) && fabs(L->z_last) <= fabs(zb))
+			c += adapt_dip(t0, L->z_penult, t1, L->z_last, t2, zb, ADAPT_DEPTH, evals);
+	}
+	if (!sign_change(L->z_last, R->z_first) && fabs(R->z_first) < fabs(L->z_last)
+			&& !sign_change(R->z_first, R->z_second) && fabs(R->z_first) <= fabs(R->z_second))
+		c += adapt_dip(t1, L->z_last, t2, R->z_first, t3, R->z_second, ADAPT_DEPTH, evals);
+	return c;
+}
+
+/*
+	Work stealing over chunks of samples
+
+	The samples are cut in chunks of equal cost (cost_bounds), about
+	CHUNKS_PER_THREAD per thread, on multiples of SAMPLE_BLOCK so the
+	engines see the same blocks whatever the number of chunks.
+	Each thread owns a deque of consecutive chunks, it takes them from the
+	front and, once empty, steals from the back of the others. A chunk
+	evaluates each of its samples once and keeps its first and last two
+	values, the crossings between chunks (and the adaptive refinement
+	around them) are added in order at the end, so the count depends
+	neither on the number of threads nor on who ran what.
+*/
+
+#ifndef CHUNKS_PER_THREAD
+#define CHUNKS_PER_THREAD 16
+#endif
+
+typedef struct chunk_deque_s {
+	omp_lock_t lock;
+	ui64 head, tail;	// chunks [head, tail) left
+} chunk_deque_t;
+
+static inline int chunk_pop(chunk_deque_t *d, ui64 *k)
+{
+	int ok = 0;
+	omp_set_lock(&d->lock);
+	if (d->head < d->tail)
+	{
+		*k = d->head++;
+		ok = 1;
+	}
+	omp_unset_lock(&d->lock);
+	return ok;
+}
+
+static inline int chunk_steal(chunk_deque_t *d, ui64 *k)
+{
+	int ok = 0;
+	omp_set_lock(&d->lock);
+	if (d->head < d->tail)
+	{
+		*k = --d->tail;
+		ok = 1;
+	}
+	omp_unset_lock(&d->lock);
+	return ok;
+}
+
+// Zeros found over the samples [0, n), *refined gets the adaptive refinement evaluations
+double count_range(const double LOWER, const double STEP, const ui64 n, double *refined)
+{
+	// the dips at the edges of the range stay inside it
+	grid_hi = HUGE_VAL;
+	grid_hi = sample_t(LOWER, STEP, (n > 0) ? n - 1 : 0);
+	const int nb_thread = omp_get_max_threads();
+	ui64 chunks = (ui64)nb_thread*CHUNKS_PER_THREAD;
+	if (chunks > n/SAMPLE_BLOCK)
+		chunks = n/SAMPLE_BLOCK;
+	if (chunks == 0)
+		chunks = 1;
+
+	ui64 *bound = (ui64 *)malloc((chunks + 1)*sizeof(ui64));
+	cost_bounds(LOWER, STEP, n, chunks, bound);
+	// half-open chunks [bound[k], bound[k+1]) on multiples of SAMPLE_BLOCK
+	ui64 c = 1;
+	for (ui64 k = 1; k < chunks; k++)
+	{
+		const ui64 e = (bound[k] + SAMPLE_BLOCK/2)/SAMPLE_BLOCK*SAMPLE_BLOCK;
+		if (e > bound[c-1] && e < n)
+			bound[c++] = e;
+	}
+	chunks = c;
+	bound[chunks] = n;
+
+	chunk_result_t *res = (chunk_result_t *)malloc(chunks*sizeof(chunk_result_t));
+	chunk_deque_t *dq = (chunk_deque_t *)malloc(nb_thread*sizeof(chunk_deque_t));
+	for (int t = 0; t < nb_thread; t++)
+	{
+		omp_init_lock(&dq[t].lock);
+		dq[t].head = (ui64)t*chunks/nb_thread;
+		dq[t].tail = (ui64)(t + 1)*chunks/nb_thread;
+	}
+
+	double ref = 0.0;
+	#pragma omp parallel num_threads(nb_thread) reduction(+:ref)
+	{
+		const int th_id = omp_get_thread_num();
+		const int nb = omp_get_num_threads();
+		workspace_t ws;
+		workspace_init(&ws);
+
+		ui64 k;
+		for (;;)
+		{
+			int found = chunk_pop(&dq[th_id], &k);
+			for (int v = 1; !found && v < nb; v++)
+				found = chunk_steal(&dq[(th_id + v) % nb], &k);
+			if (!found)
+				break;
+			count_chunk(&ws, LOWER, STEP, bound[k], bound[k+1], &res[k]);
+		}
+		ref += ws.refined;
+		workspace_free(&ws);
+	}
+
+	double count = res[0].count;
+	for (ui64 k = 1; k < chunks; k++)
+	{
+		count += res[k].count + sign_change(res[k-1].z_last, res[k].z_first);
+		if (sampling == SAMPLING_ADAPTIVE)
+			count += adapt_seam(LOWER, STEP, bound[k], &res[k-1], &res[k], &ref);
+	}
+
+	for (int t = 0; t < nb_thread; t++)
+		omp_destroy_lock(&dq[t].lock);
+	free(dq);
+	free(res);
+	free(bound);
+	*refined = ref;
+	return count;
+}
+
+/*************************************************************************
+	Baby-step/giant-step phase tables : Z anywhere in a window
+
+	Refinement and validation evaluate Z at irregular points of a known
+	window [T0, T0 + W], neither the rotors nor a samples grid apply.
+	With Nw = N(T0), c = log(Nw)/2 and t - T0 = (g NB + b) d + r, |r| <= d/2 :
+		G[g][j] = j^-1/2 e^{-i (T0 + g NB d) log j}     NG giant rows
+		B[b][j] = e^{-i b d log j}                      NB baby rows
+		j^-1/2 e^{-i t log j} = G[g][j] B[b][j] e^{-i r (log j - c)} e^{-i r c}
+	The residual phases stay under d c/2, small enough for small_sincos :
+	a term is a complex product and a short polynomial, no trig call.
+	d is the largest step keeping them under BSGS_EPS, NG ~ NB ~ sqrt(W/d).
+	A window costs (NG + NB) Nw sincos, Z_batch builds one for a cluster of
+	at least BSGS_GAIN (NG + NB) points and keeps it (bsgs_last) for the
+	later batches inside it (bisections). A Z_batch called from inside a
+	parallel region (gram_window under count_gram) builds its own window
+	and frees it on return : bsgs_last is only touched by the serial code.
+	Terms past Nw are summed directly.
+	A term costs about the same as with the avx512 tiles, half as much as
+	with the avx2 ones : -w auto uses the windows with the other kernels.
+*************************************************************************/
+
+#ifndef BSGS_EPS
+#define BSGS_EPS 1e-16
+#endif
+
+#ifndef BSGS_MAX_WIDTH
+#define BSGS_MAX_WIDTH 128.0
+#endif
+
+#ifndef BSGS_GAIN
+#define BSGS_GAIN 2.0
+#endif
+
+#ifndef BSGS_MIN_TERMS
+#define BSGS_MIN_TERMS 256
+#endif
+
+#ifndef BSGS_MAX_BYTES
+#define BSGS_MAX_BYTES (256UL << 20)
+#endif
+
+#ifndef BSGS_TILE
+#define BSGS_TILE 16
+#endif
+
+#ifndef BSGS_BLOCK
+#define BSGS_BLOCK 512
+#endif
+
+typedef struct bsgs_s {
+	double T0, W;      // window [T0, T0 + W]
+	double d, c;
+	int Nw, NG, NB;
+	size_t stride;     // term j of row k at k*stride + j
+	size_t cap;
+	double *re, *im;   // NG giant rows then NB baby rows
+} bsgs_t;
+
+int bsgs_windows = 1;
+bsgs_t bsgs_last = {0.0, -1.0, 0.0, 0.0, 0, 0, 0, 0, 0, NULL, NULL};
+
+// sin x and cos x for |x| <= (BSGS_EPS 9!)^(1/9), no range reduction
+static inline void small_sincos(const double x, double *sin_x, double *cos_x)
+{
+	const double x2 = x*x;
+	*cos_x = 1.0 + x2*(-1.0/2.0 + x2*(1.0/24.0 + x2*(-1.0/720.0 + x2*(1.0/40320.0))));
+	*sin_x = x*(1.0 + x2*(-1.0/6.0 + x2*(1.0/120.0 + x2*(-1.0/5040.0))));
+}
+
+double bsgs_step(const int Nw)
+{
+	return 2.0*pow(BSGS_EPS*362880.0, 1.0/9.0)/(0.5*log((double)Nw));
+}
+
+// NG + NB for a window of width W
+int bsgs_rows(const int Nw, const double W, int *NG, int *NB)
+{
+	const double steps = floor(W/bsgs_step(Nw)) + 2.0;
+	*NB = (int)ceil(sqrt(steps));
+	*NG = (int)ceil(steps/(*NB));
+	return *NG + *NB;
+}
+
+// Phase origin of the giant row g, the same rounding in bsgs_build and bsgs_sum
+static inline double bsgs_giant(const bsgs_t *bs, const int g)
+{
+	return bs->T0 + (double)g*bs->NB*bs->d;
+}
+
+SIMD_CLONES void bsgs_row(const double s, const int weighted, const int Nw, double *re, double *im)
+{
+	const double *isq = table_isq();
+	const double *lgi = table_lgi();
+
+	#pragma omp simd
+	for (int j = 1; j <= Nw; j++)
+	{
+		double sn, cs;
+		rs_sincos(s*lgi[TAB_STRIDE*j], &sn, &cs);
+		const double a = weighted ? isq[TAB_STRIDE*j] : 1.0;
+		re[j] =  a*cs;
+		im[j] = -a*sn;
+	}
+}
+
+// Window [T0, T0 + W], the tables must cover T0 + W
+void bsgs_build(bsgs_t *bs, const double T0, const double W)
+{
+	const double two_pi = 2.0 * 3.1415926535897932385;
+	bs->T0 = T0;
+	bs->W  = W;
+	bs->Nw = (int)sqrt(T0/two_pi);
+	bs->c  = 0.5*log((double)bs->Nw);
+	bs->d  = bsgs_step(bs->Nw);
+	bsgs_rows(bs->Nw, W, &bs->NG, &bs->NB);
+	bs->stride = (size_t)bs->Nw + 1;
+	const size_t size = (size_t)(bs->NG + bs->NB)*bs->stride;
+	if (size > bs->cap)
+	{
+		free(bs->re);
+		bs->re  = (double *)malloc(2*size*sizeof(double));
+		bs->cap = size;
+	}
+	bs->im = bs->re + bs->cap;
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int k = 0; k < bs->NG + bs->NB; k++)
+	{
+		double *re = bs->re + k*bs->stride;
+		double *im = bs->im + k*bs->stride;
+		if (k < bs->NG)
+			bsgs_row(bsgs_giant(bs, k), 1, bs->Nw, re, im);
+		else
+			bsgs_row((double)(k - bs->NG)*bs->d, 0, bs->Nw, re, im);
+	}
+}
+
+void bsgs_free(bsgs_t *bs)
+{
+	free(bs->re);
+	bs->re = bs->im = NULL;
+	bs->cap = 0;
+	bs->W = -1.0;
+}
+
+// Rows g and b of t in the window, returns the residual r
+static inline double bsgs_locate(const bsgs_t *bs, const double t, int *g, int *b)
+{
+	long k = lround((t - bs->T0)/bs->d);
+	if (k < 0)
+		k = 0;
+	if (k >= (long)bs->NG*bs->NB)
+		k = (long)bs->NG*bs->NB - 1;
+	*g = (int)(k/bs->NB);
+	*b = (int)(k%bs->NB);
+	return (t - bsgs_giant(bs, *g)) - (double)(*b)*bs->d;
+}
+
+/*
+	W_re[p] + i W_im[p] = sum over [1, Nw] of j^-1/2 e^{-i t log j} for n <= BSGS_TILE
+	points on the same giant row g : by blocks of BSGS_BLOCK terms, so the
+	giant row and log j are read from L1 for all the points but the first
+*/
+SIMD_CLONES void bsgs_sum_tile(const bsgs_t *bs, const int g, const int *b, const double *r, const int n,
+		double *W_re, double *W_im)
+{
+	const double *lgi = table_lgi();
+	const double *G_re = bs->re + g*bs->stride;
+	const double *G_im = bs->im + g*bs->stride;
+	const double c = bs->c;
+	double acc_re[BSGS_TILE];
+	double acc_im[BSGS_TILE];
+	for (int p = 0; p < n; p++)
+		acc_re[p] = acc_im[p] = 0.0;
+
+	for (int j0 = 1; j0 <= bs->Nw; j0 += BSGS_BLOCK)
+	{
+		const int j1 = (j0 + BSGS_BLOCK - 1 < bs->Nw) ? j0 + BSGS_BLOCK - 1 : bs->Nw;
+		for (int p = 0; p < n; p++)
+		{
+			const double *B_re = bs->re + (bs->NG + b[p])*bs->stride;
+			const double *B_im = bs->im + (bs->NG + b[p])*bs->stride;
+			const double rp = r[p];
+			double re = 0.0, im = 0.0;
+			#pragma omp simd reduction(+:re,im)
+			for (int j = j0; j <= j1; j++)
+			{
+				const double x_re = G_re[j]*B_re[j] - G_im[j]*B_im[j];
+				const double x_im = G_re[j]*B_im[j] + G_im[j]*B_re[j];
+				double s, co;
+				small_sincos(rp*(lgi[TAB_STRIDE*j] - c), &s, &co);
+				re += x_re*co + x_im*s;
+				im += x_im*co - x_re*s;
+			}
+			acc_re[p] += re;
+			acc_im[p] += im;
+		}
+	}
+	for (int p = 0; p < n; p++)
+	{
+		double s, co;
+		small_sincos(r[p]*c, &s, &co);
+		W_re[p] = acc_re[p]*co + acc_im[p]*s;
+		W_im[p] = acc_im[p]*co - acc_re[p]*s;
+	}
+}
+
+/*
+	1 when the m points of [t0, t1] go through the window bs : it covers them
+	already, or they pay for a new window
+*/
+int bsgs_window(bsgs_t *bs, const double t0, const double t1, const size_t m)
+{
+	const double two_pi = 2.0 * 3.1415926535897932385;
+	const int Nw = (int)sqrt(t0/two_pi);
+	if (!bsgs_windows || Nw < BSGS_MIN_TERMS)
+		return 0;
+	if (t0 >= bs->T0 && t1 <= bs->T0 + bs->W)
+		return 1;
+	int NG, NB;
+	const int rows = bsgs_rows(Nw, t1 - t0, &NG, &NB);
+	if ((double)m < BSGS_GAIN*rows || (double)rows*(Nw + 1)*2.0*sizeof(double) > (double)BSGS_MAX_BYTES)
+		return 0;
+	bsgs_build(bs, t0, t1 - t0);
+	return 1;
+}
+
+/*************************************************************************
+	Batch evaluation : out[i] = Z(t[i]) for arbitrary t[i]
+
+	The points are sorted by t, so the points sharing the same number of
+	terms N = floor(sqrt(t/2pi)) are next to each other. theta() and the
+	remainder are evaluated over a whole chunk of points in simd loops,
+	then the main sum is done group by group (TILE_K points at once) and
+	the results are written back in the caller's order.
+	The tables must cover the largest t (compute_table).
+*************************************************************************/
+
+#ifndef BATCH_CHUNK
+#define BATCH_CHUNK 256
+#endif
+
+typedef struct batch_point_s {
+	double t;
+	size_t idx;
+} batch_point_t;
+
+int batch_point_cmp(const void *a, const void *b)
+{
+	const double ta = ((const batch_point_t *)a)->t;
+	const double tb = ((const batch_point_t *)b)->t;
+	return (ta > tb) - (ta < tb);
+}
+
+SIMD_CLONES void theta_batch(const double *t, double *tt, const size_t n)
+{
+	#pragma omp simd
+	for (size_t i = 0; i < n; i++)
+		tt[i] = theta(t[i]);
+}
+
+// The points pt[0, n) by chunks, main sums from the window bs (NULL : tiles)
+void batch_chunks(const batch_point_t *pt, const size_t n, double *out, const bsgs_t *bs)
+{
+	#pragma omp parallel for schedule(dynamic)
+	for (size_t c = 0; c < n; c += BATCH_CHUNK)
+	{
+		double ts[BATCH_CHUNK];
+		double tt[BATCH_CHUNK];
+		double R[BATCH_CHUNK];
+		int    Ns[BATCH_CHUNK];
+		const size_t m = (n - c < BATCH_CHUNK) ? n - c : BATCH_CHUNK;
+
+		for (size_t k = 0; k < m; k++)
+			ts[k] = pt[c+k].t;
+		theta_batch(ts, tt, m);
+		R_batch(ts, Ns, R, m);
+
+		if (bs != NULL)
+		{
+			// runs of points on the same giant row, BSGS_TILE at once
+			int g[BATCH_CHUNK], b[BATCH_CHUNK];
+			double r[BATCH_CHUNK], W_re[BATCH_CHUNK], W_im[BATCH_CHUNK];
+			for (size_t k = 0; k < m; k++)
+				r[k] = bsgs_locate(bs, ts[k], g + k, b + k);
+			for (size_t k = 0; k < m; )
+			{
+				size_t e = k + 1;
+				while (e < m && e - k < BSGS_TILE && g[e] == g[k])
+					e++;
+				bsgs_sum_tile(bs, g[k], b + k, r + k, (int)(e - k), W_re + k, W_im + k);
+				k = e;
+			}
+			for (size_t k = 0; k < m; k++)
+			{
+				double sum = cos(tt[k])*W_re[k] - sin(tt[k])*W_im[k];
+				if (Ns[k] > bs->Nw)
+					sum += main_sum_terms(ts[k], tt[k], bs->Nw + 1, Ns[k]);
+				out[pt[c+k].idx] = 2.0*sum + R[k];
+			}
+			continue;
+		}
+		for (size_t g = 0; g < m; )
+		{
+			// group [g, e) shares the same N
+			const int N = Ns[g];
+			size_t e = g;
+			while (e < m && Ns[e] == N)
+				e++;
+			size_t k = g;
+			for (; k + TILE_K <= e; k += TILE_K)
+			{
+				double ZZ[TILE_K];
+				main_sum_tile(ts + k, tt + k, Ns + k, ZZ);
+				for (int l = 0; l < TILE_K; l++)
+					out[pt[c+k+l].idx] = 2.0*ZZ[l] + R[k+l];
+			}
+			for (; k < e; k++)
+				out[pt[c+k].idx] = 2.0*main_sum_terms(ts[k], tt[k], 1, N) + R[k];
+			g = e;
+		}
+	}
+}
+
+void Z_batch(const double *t, double *out, size_t n)
+{
+	const double two_pi = 2.0 * 3.1415926535897932385;
+	batch_point_t *pt = (batch_point_t *)malloc(n*sizeof(batch_point_t));
+	for (size_t i = 0; i < n; i++)
+	{
+		pt[i].t = t[i];
+		pt[i].idx = i;
+	}
+	qsort(pt, n, sizeof(batch_point_t), batch_point_cmp);
+
+	// with -p the points of SPLIT_MIN_TERMS terms or more [big, n) are split one by one
+	size_t big = n;
+	if (split_eval)
+		while (big > 0 && (int)sqrt(pt[big-1].t/two_pi) >= SPLIT_MIN_TERMS)
+			big--;
+	for (size_t i = big; i < n; i++)
+		out[pt[i].idx] = Z(pt[i].t);
+
+	// clusters of BSGS_MAX_WIDTH through the phase tables, the other points are moved to the front
+	// bsgs_last is shared : inside a parallel region the window lives for this call only
+	bsgs_t own = {0.0, -1.0, 0.0, 0.0, 0, 0, 0, 0, 0, NULL, NULL};
+	bsgs_t *bs = omp_in_parallel() ? &own : &bsgs_last;
+	size_t rest = 0;
+	for (size_t i = 0, e = 0; i < big; )
+	{
+		while (e < big && pt[e].t - pt[i].t <= BSGS_MAX_WIDTH)
+			e++;
+		if (bsgs_window(bs, pt[i].t, pt[e-1].t, e - i))
+		{
+			batch_chunks(pt + i, e - i, out, bs);
+			i = e;
+		}
+		else
+			pt[rest++] = pt[i++];
+	}
+	batch_chunks(pt, rest, out, NULL);
+	bsgs_free(&own);
+	free(pt);
+}
+
+/*
+	Checks Z on a file of known zeros (see RiemannSiegel_Original.cpp), lines are "t" or "index t"
+	The second column should be close to 0.0
+*/
+void test_fileof_zeros(const char *fname)
+{
+	const double pi = 3.1415926535897932385;
+	char line[1024];
+	FILE *fi=fopen(fname,"r");
+	if (fi == NULL){
+		printf("cannot open %s\n",fname);
+		exit(0);
+	}
+	size_t n = 0, size = 1024;
+	double *t = (double *)malloc(size*sizeof(double));
+	double tmax = 0.0;
+	while (fgets(line,1000,fi) != NULL){
+		double a, b;
+		const int k = sscanf(line,"%lf %lf",&a,&b);
+		if (k < 1)
+			continue;
+		if (n == size){
+			size *= 2;
+			t = (double *)realloc(t, size*sizeof(double));
+		}
+		t[n] = (k == 2) ? b : a;
+		if (t[n] > tmax)
+			tmax = t[n];
+		n++;
+	}
+	fclose(fi);
+
+	compute_table(sqrt(tmax/(2*pi))+1);
+	double *RS = (double *)malloc(n*sizeof(double));
+	Z_batch(t, RS, n);
+	for (size_t i = 0; i < n; i++)
+		printf(" %30.20lf %30.20lf\n",t[i],RS[i]);
+	free(RS);
+	free(t);
+}
+
+/*************************************************************************
+	Gram point sampling
+
+	The Gram point g_n is the solution of theta(g_n) = n*pi. Gram's law
+	says (-1)^n Z(g_n) > 0 and holds most of the time, so sampling Z on
+	the Gram points already finds almost every zero with about one
+	evaluation per zero. A Gram block [g_a, g_b] is delimited by two
+	consecutive "good" Gram points (the ones following Gram's law) and by
+	Rosser's rule it holds at least b-a zeros. Only the blocks where less
+	sign changes are seen are refined (midpoints, up to GRAM_DEPTH times).
+	The two edges [LOWER, first good point] and [last good point, UPPER]
+	are always refined to GRAM_DEPTH.
+	The Gram indices are split in windows of GRAM_WINDOW points, a window
+	owns the blocks starting from its first good Gram point, so every
+	window is independent.
+*************************************************************************/
+
+#ifndef GRAM_WINDOW
+#define GRAM_WINDOW 4096
+#endif
+
+#ifndef GRAM_DEPTH
+#define GRAM_DEPTH 8
+#endif
+
+typedef struct gram_stats_s {
+	double points;
+	double evals;
+	double unresolved;
+} gram_stats_t;
+
+// Sampled points of a Gram block, sorted by t
+typedef struct gram_seg_s {
+	double *t;
+	double *z;
+	size_t n, size;
+	int depth;
+} gram_seg_t;
+
+// Solves theta(g) = n*pi by Newton iterations from guess
+double gram_point(const double n, const double guess)
+{
+	const double pi = 3.1415926535897932385;
+	double g = guess;
+	for (int it = 0; it < 64; it++)
+	{
+		const double d = (theta(g) - n*pi)/(0.5*log(g/(2.0*pi)));
+		g -= d;
+		if (fabs(d) < 1e-9)
+			break;
+	}
+	return g;
+}
+
+/*
+	Starting guess from theta(t) ~ t/2 log(t/(2 pi e)) - pi/8
+	For small n, a point on the right of g_n (theta is convex after 7.0,
+	Newton from the right converges)
+*/
+double gram_guess(const double n)
+{
+	const double pi = 3.1415926535897932385;
+	const double e  = 2.7182818284590452354;
+	if (n < 100.0)
+		return 30.0 + 10.0*(n + 1.0);
+	double g = 2.0*pi*(n + 0.125);
+	for (int it = 0; it < 8; it++)
+		g = 2.0*pi*(n + 0.125)/log(g/(2.0*pi*e));
+	return g;
+}
+
+static inline int gram_good(const double n, const double z)
+{
+	return (fmod(fabs(n), 2.0) == 0.0) ? (z > 0.0) : (z < 0.0);
+}
+
+static inline void gram_reserve(gram_seg_t *s, const size_t n)
+{
+	if (n > s->size)
+	{
+		s->size = (2*s->size > n) ? 2*s->size : ((n > 64) ? n : 64);
+		s->t = (double *)realloc(s->t, s->size*sizeof(double));
+		s->z = (double *)realloc(s->z, s->size*sizeof(double));
+	}
+}
+
+static inline void gram_push(gram_seg_t *s, const double t, const double z)
+{
+	gram_reserve(s, s->n + 1);
+	s->t[s->n] = t;
+	s->z[s->n] = z;
+	s->n++;
+}
+
+static inline double gram_changes(const gram_seg_t *s)
+{
+	double c = 0.0;
+	for (size_t i = 1; i < s->n; i++)
+		c += (signbit(s->z[i]) != signbit(s->z[i-1]));
+	return c;
+}
+
+// One refinement level : the midpoints of s are evaluated and inserted
+void gram_refine(gram_seg_t *s, gram_stats_t *st)
+{
+	const size_t n = s->n;
+	double *mid = (double *)malloc(2*(n-1)*sizeof(double));
+	for (size_t i = 0; i + 1 < n; i++)
+		mid[i] = 0.5*(s->t[i] + s->t[i+1]);
+	Z_batch(mid, mid + n - 1, n - 1);
+	st->evals += n - 1;
+
+	// interleave the midpoints, from the end
+	gram_reserve(s, 2*n - 1);
+	s->n = 2*n - 1;
+	for (size_t i = n - 1; i > 0; i--)
+	{
+		s->t[2*i]   = s->t[i];
+		s->z[2*i]   = s->z[i];
+		s->t[2*i-1] = mid[i-1];
+		s->z[2*i-1] = mid[n-1 + i-1];
+	}
+	free(mid);
+	s->depth++;
+}
+
+/*
+	Counts the sign changes of the block s, refining it while less than
+	need are found (edge : always refined to GRAM_DEPTH).
+	A Rosser rule exception moves the missing zeros to a neighbour block :
+	on a deficit the previous block is refined to GRAM_DEPTH, what is
+	still missing is left in *pending and the next block is refined to
+	GRAM_DEPTH as well. A deficit that none of the two neighbours makes up
+	is an unresolved block.
+	The block is then moved to prev and s keeps its last point only.
+*/
+double gram_block(gram_seg_t *s, gram_seg_t *prev, const double need, const int edge,
+		double *pending, gram_stats_t *st)
+{
+	double c = gram_changes(s);
+	while (s->depth < GRAM_DEPTH && (edge || *pending > 0.0 || c < need))
+	{
+		gram_refine(s, st);
+		c = gram_changes(s);
+	}
+	if (*pending > 0.0 && c - need < *pending)
+		st->unresolved += 1.0;
+	*pending = 0.0;
+
+	if (!edge && c < need)
+	{
+		double extra = 0.0;
+		if (prev->n > 1)
+		{
+			const double c0 = gram_changes(prev);
+			while (prev->depth < GRAM_DEPTH)
+				gram_refine(prev, st);
+			extra = gram_changes(prev) - c0;
+		}
+		c += extra;
+		if (c < need)
+			*pending = need - c;
+	}
+
+	gram_seg_t tmp = *prev;
+	*prev = *s;
+	*s = tmp;
+	s->n = 0;
+	s->depth = 0;
+	gram_push(s, prev->t[prev->n-1], prev->z[prev->n-1]);
+	return c;
+}
+
+/*
+	Zeros found in the window of Gram indices [a, b), n_lo and n_hi are
+	the first and last Gram indices in [LOWER, UPPER]
+*/
+double gram_window(const double a, const double b, const double n_lo, const double n_hi,
+		const double LOWER, const double UPPER, gram_stats_t *st)
+{
+	const double m = ((b < n_hi + 1.0) ? b : n_hi + 1.0) - a;
+	double *g = (double *)malloc(2*(size_t)m*sizeof(double));
+	double *z = g + (size_t)m;
+	gram_seg_t s = {NULL, NULL, 0, 0, 0};
+	gram_seg_t prev = {NULL, NULL, 0, 0, 0};
+	double pending = 0.0;
+	double count = 0.0;
+
+	g[0] = gram_point(a, gram_guess(a));
+	for (size_t i = 1; i < (size_t)m; i++)
+		g[i] = gram_point(a + i, g[i-1] + 2.0*3.1415926535897932385/log(g[i-1]/(2.0*3.1415926535897932385)));
+	Z_batch(g, z, (size_t)m);
+	st->points += m;
+	st->evals  += m;
+
+	// start of the first block owned by this window
+	double n = a;
+	double last = a;
+	int edge = 0;
+	if (a == n_lo)
+	{
+		gram_push(&s, LOWER, Z(LOWER));
+		st->evals += 1.0;
+		edge = 1;
+		last = a - 1.0;
+	}
+	else
+	{
+		while (n < a + m && !gram_good(n, z[(size_t)(n-a)]))
+			n += 1.0;
+		if (n < a + m)
+		{
+			gram_push(&s, g[(size_t)(n-a)], z[(size_t)(n-a)]);
+			last = n;
+			n += 1.0;
+		}
+	}
+
+	double gn = g[(size_t)m-1];
+	while (s.n > 0)
+	{
+		double tn, zn;
+		if (n > n_hi)
+		{
+			// UPPER edge
+			gram_push(&s, UPPER, Z(UPPER));
+			st->evals += 1.0;
+			count += gram_block(&s, &prev, 0.0, 1, &pending, st);
+			break;
+		}
+		if (n < a + m)
+		{
+			tn = g[(size_t)(n-a)];
+			zn = z[(size_t)(n-a)];
+		}
+		else
+		{
+			// past the window, up to the next good Gram point
+			gn = gram_point(n, gn + 2.0*3.1415926535897932385/log(gn/(2.0*3.1415926535897932385)));
+			tn = gn;
+			zn = Z(tn);
+			st->points += 1.0;
+			st->evals  += 1.0;
+		}
+		gram_push(&s, tn, zn);
+		if (gram_good(n, zn))
+		{
+			count += gram_block(&s, &prev, n - last, edge, &pending, st);
+			edge = 0;
+			last = n;
+			if (n >= b)
+				break;
+		}
+		n += 1.0;
+	}
+	free(s.t);
+	free(s.z);
+	free(prev.t);
+	free(prev.z);
+	free(g);
+	return count;
+}
+
+double count_gram(const double LOWER, const double UPPER, gram_stats_t *st)
+{
+	const double pi = 3.1415926535897932385;
+	const double n_lo = ceil(theta(LOWER)/pi);
+	const double n_hi = floor(theta(UPPER)/pi);
+	double count = 0.0, points = 0.0, evals = 0.0, unresolved = 0.0;
+
+	if (n_hi < n_lo)
+	{
+		// no Gram point in the range
+		gram_seg_t s = {NULL, NULL, 0, 0, 0};
+		gram_seg_t prev = {NULL, NULL, 0, 0, 0};
+		double pending = 0.0;
+		gram_push(&s, LOWER, Z(LOWER));
+		gram_push(&s, UPPER, Z(UPPER));
+		st->points = 0.0;
+		st->evals = 2.0;
+		st->unresolved = 0.0;
+		count = gram_block(&s, &prev, 0.0, 1, &pending, st);
+		free(s.t);
+		free(s.z);
+		free(prev.t);
+		free(prev.z);
+		return count;
+	}
+
+	const ui64 windows = (ui64)((n_hi - n_lo)/GRAM_WINDOW) + 1;
+	#pragma omp parallel for schedule(dynamic) reduction(+:count,points,evals,unresolved)
+	for (ui64 w = 0; w < windows; w++)
+	{
+		gram_stats_t ws = {0.0, 0.0, 0.0};
+		const double a = n_lo + (double)w*GRAM_WINDOW;
+		count += gram_window(a, a + GRAM_WINDOW, n_lo, n_hi, LOWER, UPPER, &ws);
+		points += ws.points;
+		evals += ws.evals;
+		unresolved += ws.unresolved;
+	}
+	st->points = points;
+	st->evals = evals;
+	st->unresolved = unresolved;
+	return count;
+}
+
+/*
+	Builds the density grid of [LOWER, UPPER] with SAMP samples per mean
+	zero spacing, returns the number of samples. The last block is closed
+	on UPPER : its step is shortened so that the last sample is UPPER.
+*/
+ui64 density_grid(const double LOWER, const double UPPER, const double SAMP)
+{
+	const double pi = 3.1415926535897932385;
+	const double u0 = theta(LOWER)/pi;
+	const double u1 = theta(UPPER)/pi;
+	const ui64 n = (ui64)ceil((u1 - u0)*SAMP) + 1;
+	const ui64 blocks = (n + SAMPLE_BLOCK - 1)/SAMPLE_BLOCK;
+
+	grid_T = (double *)malloc((blocks + 1)*sizeof(double));
+	grid_H = (double *)malloc((blocks + 1)*sizeof(double));
+	#pragma omp parallel for schedule(dynamic, 64)
+	for (ui64 b = 0; b <= blocks; b++)
+	{
+		const double u = u0 + (double)(b*SAMPLE_BLOCK)/SAMP;
+		grid_T[b] = (b == 0) ? LOWER : gram_point(u, gram_guess(u));
+	}
+	for (ui64 b = 0; b < blocks; b++)
+		grid_H[b] = (grid_T[b+1] - grid_T[b])/SAMPLE_BLOCK;
+	const ui64 last = blocks - 1, steps = n - 1 - last*SAMPLE_BLOCK;
+	if (steps == 0)
+		grid_T[last] = UPPER;
+	else
+		grid_H[last] = (UPPER - grid_T[last])/(double)steps;
+	grid_H[blocks] = grid_H[last];
+	return n;
+}
+
+/*************************************************************************
+	Turing's method : certification of the number of zeros found
+
+	N(T) = theta(T)/pi + 1 + S(T) and for 168 pi < t1 < t2 (Lehman)
+	|int_{t1}^{t2} S(t) dt| <= 2.30 + 0.128 log(t2/2pi).
+	The zeros on [T-h, T+h] are located (sign changes on a fine grid,
+	then bisection), since N(t) >= N(T) + zeros in (T, t] on the right and
+	N(t) <= N(T) - zeros in (t, T] on the left, the integral bound gives
+	an upper and a lower bound on N(T). N(T) is proved when they meet on
+	one integer. h = TURING_H times the bound, zeros missed near T only
+	loosen the bounds. Z() is taken as exact.
+*************************************************************************/
+
+#ifndef TURING_H
+#define TURING_H 8.0
+#endif
+
+// samples per mean zero spacing on [T-h, T+h]
+#ifndef TURING_SAMP
+#define TURING_SAMP 16.0
+#endif
+
+#ifndef TURING_BISECT
+#define TURING_BISECT 16
+#endif
+
+// No zero below the first one
+#define FIRST_ZERO 14.134725141734693790
+
+double turing_bound(const double t)
+{
+	return 2.30 + 0.128*log(t/(2.0*3.1415926535897932385));
+}
+
+double turing_width(const double T)
+{
+	return TURING_H*turing_bound(T);
+}
+
+/*
+	Mean of theta(t)/pi + 1 over [a, b], trapezoids (theta'' = 1/2t)
+	The mean and not the integral : at large t, b - a is not exact and
+	int/h would be off by theta/pi * ulp(t)/h
+*/
+double turing_theta_mean(const double a, const double b)
+{
+	const double pi = 3.1415926535897932385;
+	const int n = 4096;
+	const double h = (b - a)/n;
+	double s = 0.5*(theta(a) + theta(b));
+	for (int i = 1; i < n; i++)
+		s += theta(a + i*h);
+	return s/(n*pi) + 1.0;
+}
+
+/*
+	Bounds on N(T) : *lo <= N(T) <= *hi
+	returns 1 when N(T) is proved (*lo == *hi), 0 otherwise
+	(*hi is -1 when T is too small for Turing's method)
+*/
+int turing_N(const double T, double *lo, double *hi)
+{
+	const double pi = 3.1415926535897932385;
+	if (T < FIRST_ZERO)
+	{
+		*lo = *hi = 0.0;
+		return 1;
+	}
+	const double h = (T + turing_width(T)) - T;
+	if (T - h <= 168.0*pi)
+	{
+		*lo = 0.0;
+		*hi = -1.0;
+		return 0;
+	}
+
+	// grid with T on a sample, so a bracket is all on one side of T, the step stays above the resolution of t
+	ui64 M = (ui64)ceil(h*TURING_SAMP*log(T/(2.0*pi))/(2.0*pi));
+	if (h/M < 8.0*T*DBL_EPSILON)
+		M = (ui64)(h/(8.0*T*DBL_EPSILON)) + 1;
+	const double step = h/M;
+	const size_t n = 2*M + 1;
+	double *t = (double *)malloc(2*n*sizeof(double));
+	double *z = t + n;
+	for (size_t i = 0; i < n; i++)
+		t[i] = T + ((double)i - (double)M)*step;
+	t[M] = T;
+	Z_batch(t, z, n);
+
+	// brackets [a, b] of the sign changes, za is the sign of Z(a)
+	size_t nb = 0;
+	double *a  = (double *)malloc(4*n*sizeof(double));
+	double *b  = a + n;
+	double *za = b + n;
+	double *m  = za + n;
+	for (size_t i = 1; i < n; i++)
+	{
+		if (signbit(z[i]) != signbit(z[i-1]))
+		{
+			a[nb]  = t[i-1];
+			b[nb]  = t[i];
+			za[nb] = z[i-1];
+			nb++;
+		}
+	}
+	for (int it = 0; it < TURING_BISECT && nb > 0; it++)
+	{
+		for (size_t k = 0; k < nb; k++)
+			t[k] = 0.5*(a[k] + b[k]);
+		Z_batch(t, m, nb);
+		for (size_t k = 0; k < nb; k++)
+		{
+			if (signbit(m[k]) == signbit(za[k]))
+				a[k] = t[k];
+			else
+				b[k] = t[k];
+		}
+	}
+
+	// zeros on the left counted from the left end of their bracket, on the right from the right end
+	double left = 0.0, right = 0.0;
+	for (size_t k = 0; k < nb; k++)
+	{
+		if (b[k] <= T)
+			left += a[k] - (T - h);
+		else
+			right += (T + h) - b[k];
+	}
+	free(a);
+	free(t);
+
+	const double U = turing_theta_mean(T, T + h) + (turing_bound(T + h) - right)/h;
+	const double L = turing_theta_mean(T - h, T) + (left - turing_bound(T))/h;
+	*lo = ceil(L);
+	*hi = floor(U);
+	return (*lo == *hi);
+}
+
+// Checks count against N(UPPER) - N(LOWER)
+void turing_certify(const double LOWER, const double UPPER, const double count)
+{
+	double lo_l, hi_l, lo_u, hi_u;
+	const int ok_l = turing_N(LOWER, &lo_l, &hi_l);
+	const int ok_u = turing_N(UPPER, &lo_u, &hi_u);
+
+	if (hi_l < 0.0 || hi_u < 0.0)
+	{
+		printf("Turing : cannot certify, LOWER must be below %.6lf or above 168 pi + h\n",FIRST_ZERO);
+		return;
+	}
+	printf("Turing : %1.0lf <= N(LOWER) <= %1.0lf, %1.0lf <= N(UPPER) <= %1.0lf\n",lo_l,hi_l,lo_u,hi_u);
+	if (lo_l > hi_l || lo_u > hi_u)
+	{
+		printf("Turing : count not certified, the bounds contradict (Z is not accurate enough)\n");
+		return;
+	}
+	if (!ok_l || !ok_u)
+	{
+		printf("Turing : count not certified, the bounds do not meet\n");
+		return;
+	}
+	const double expected = lo_u - lo_l;
+	if (count == expected)
+		printf("Turing : count certified, N(UPPER) - N(LOWER) = %1.0lf\n",expected);
+	else
+		printf("Turing : count WRONG, N(UPPER) - N(LOWER) = %1.0lf, %1.0lf zeros missed\n",expected,expected - count);
+}
+
+int main(int argc,char **argv)
+{
+	double LOWER,UPPER,SAMP;
+	const double pi = 3.1415926535897932385;
+	
+	const char *kernel = "auto";
+	const char *zeros_file = NULL;
+	int certify = 0;
+	int windows = -1;
+	bind_t bind = BIND_NONE;
+	
+	if(argc<4){
+		printf("usage : %s LOWER UPPER SAMP [options]\n",argv[0]);
+		printf("  -k auto|scalar|portable|sse2|avx2|avx512|sieve|mixed  main sum kernel\n");
+		printf("  -e direct|rotor|tile|os|taylor|offset    sample engine\n");
+		printf("  -g uniform|density                       sample grid (density : SAMP samples per mean zero spacing)\n");
+		printf("  -s uniform|gram|adaptive                 sampling (gram : Gram points, SAMP is not used,\n");
+		printf("                                           adaptive : SAMP coarse samples refined where zeros may hide)\n");
+		printf("  -c                                       certify the count with Turing's method\n");
+		printf("  -b none|compact|spread                   pin the threads on the cpus, node after node or spread over the nodes\n");
+		printf("  -x auto|never|N                          table-free main sums from N terms on (auto : tables larger than the cache)\n");
+		printf("  -w auto|on|off                           phase table windows for the batches of Z (auto : not with avx512)\n");
+		printf("  -p                                       split each Z() of %d terms or more over the threads\n",SPLIT_MIN_TERMS);
+		printf("  -q                                       double-double then %s for the samples of Z() whose sign is not sure\n",F128_NAME);
+		printf("  -z FILE                                  print Z on the known zeros of FILE (ZEROS) and exit\n");
+		exit(0);
+	}
+	LOWER=atof(argv[1]);
+	UPPER=atof(argv[2]);
+	SAMP=atof(argv[3]);
+	gen_crossover = gen_auto_crossover();
+	for (int i = 4; i < argc; i++){
+		if (!strcmp(argv[i], "-k") && i+1 < argc){
+			kernel = argv[++i];
+		}
+		else if (!strcmp(argv[i], "-z") && i+1 < argc){
+			zeros_file = argv[++i];
+		}
+		else if (!strcmp(argv[i], "-e") && i+1 < argc){
+			i++;
+			if (!strcmp(argv[i], "direct"))
+				engine = ENGINE_DIRECT;
+			else if (!strcmp(argv[i], "rotor"))
+				engine = ENGINE_ROTOR;
+			else if (!strcmp(argv[i], "tile"))
+				engine = ENGINE_TILE;
+			else if (!strcmp(argv[i], "os"))
+				engine = ENGINE_OS;
+			else if (!strcmp(argv[i], "taylor"))
+				engine = ENGINE_TAYLOR;
+			else if (!strcmp(argv[i], "offset"))
+				engine = ENGINE_OFFSET;
+			else{
+				printf("unknown engine %s\n",argv[i]);
+				exit(0);
+			}
+		}
+		else if (!strcmp(argv[i], "-g") && i+1 < argc){
+			i++;
+			if (!strcmp(argv[i], "uniform"))
+				grid = GRID_UNIFORM;
+			else if (!strcmp(argv[i], "density"))
+				grid = GRID_DENSITY;
+			else{
+				printf("unknown grid %s\n",argv[i]);
+				exit(0);
+			}
+		}
+		else if (!strcmp(argv[i], "-c")){
+			certify = 1;
+		}
+		else if (!strcmp(argv[i], "-b") && i+1 < argc){
+			i++;
+			if (!strcmp(argv[i], "none"))
+				bind = BIND_NONE;
+			else if (!strcmp(argv[i], "compact"))
+				bind = BIND_COMPACT;
+			else if (!strcmp(argv[i], "spread"))
+				bind = BIND_SPREAD;
+			else{
+				printf("unknown binding %s\n",argv[i]);
+				exit(0);
+			}
+		}
+		else if (!strcmp(argv[i], "-x") && i+1 < argc){
+			i++;
+			if (!strcmp(argv[i], "auto"))
+				gen_crossover = gen_auto_crossover();
+			else if (!strcmp(argv[i], "never"))
+				gen_crossover = 0;
+			else
+				gen_crossover = atoi(argv[i]);
+		}
+		else if (!strcmp(argv[i], "-w") && i+1 < argc){
+			i++;
+			if (!strcmp(argv[i], "auto"))
+				windows = -1;
+			else if (!strcmp(argv[i], "on"))
+				windows = 1;
+			else if (!strcmp(argv[i], "off"))
+				windows = 0;
+			else{
+				printf("unknown windows %s\n",argv[i]);
+				exit(0);
+			}
+		}
+		else if (!strcmp(argv[i], "-p")){
+			split_eval = 1;
+		}
+		else if (!strcmp(argv[i], "-q")){
+			prec_ladder = 1;
+		}
+		else if (!strcmp(argv[i], "-s") && i+1 < argc){
+			i++;
+			if (!strcmp(argv[i], "uniform"))
+				sampling = SAMPLING_UNIFORM;
+			else if (!strcmp(argv[i], "gram"))
+				sampling = SAMPLING_GRAM;
+			else if (!strcmp(argv[i], "adaptive"))
+				sampling = SAMPLING_ADAPTIVE;
+			else{
+				printf("unknown sampling %s\n",argv[i]);
+				exit(0);
+			}
+		}
+		else{
+			printf("unknown option %s\n",argv[i]);
+			exit(0);
+		}
+	}
+	if (LOWER<0.0 || UPPER<0.0){
+		printf("LOWER and UPPER must be positive\n");
+		exit(0);
+	}
+	if (LOWER>UPPER){
+		printf("LOWER must be lower than UPPER\n");
+		exit(0);
+	}
+	if ((sampling == SAMPLING_GRAM || grid == GRID_DENSITY) && LOWER<7.0){
+		printf("Gram sampling and density grid need LOWER superior or equal to 7.0\n");
+		exit(0);
+	}
+	if (SAMP<1.0){
+		printf("SAMP must be superior or equal to 1.0\n");
+		exit(0);
+	}
+	const char *kernel_name = select_kernel(kernel);
+	if (kernel_name == NULL){
+		printf("main sum kernel %s is not available\n",kernel);
+		exit(0);
+	}
+	printf("Main sum kernel : %s\n",kernel_name);
+	bsgs_windows = (windows != 0);
+#ifdef X86_SIMD
+	if (windows < 0)
+		bsgs_windows = (main_sum_tile != main_sum_tile_avx512);
+#endif
+	numa_init(bind);
+
+	if (zeros_file != NULL){
+		test_fileof_zeros(zeros_file);
+		return(0);
+	}
+
+
+	double estimate_zeros=theta(UPPER)/pi;
+	printf("I estimate I will find %1.3lf zeros\n",estimate_zeros);
+
+	double STEP = 1.0/SAMP;
+	ui64   NUMSAMPLES=floor((UPPER-LOWER)*SAMP+1.0);
+	double count=0.0;
+	double refined=0.0;
+	double t1=dml_micros();
+
+	compute_table(sqrt((certify ? UPPER + turing_width(UPPER) : UPPER)/(2*pi))+1);
+	if (grid == GRID_DENSITY && sampling != SAMPLING_GRAM)
+		NUMSAMPLES = density_grid(LOWER, UPPER, SAMP);
+
+	if (sampling == SAMPLING_GRAM)
+	{
+		gram_stats_t st;
+		count = count_gram(LOWER, UPPER, &st);
+		printf("Gram points : %1.0lf, Z evaluations : %1.0lf, unresolved Gram blocks : %1.0lf\n",
+			st.points, st.evals, st.unresolved);
+	}
+	else
+		count = count_range(LOWER, STEP, NUMSAMPLES, &refined);
+	double t2=dml_micros();
+	if (sampling == SAMPLING_ADAPTIVE)
+		printf("Samples : %1.0lf, refinement evaluations : %1.0lf\n",(double)NUMSAMPLES,refined);
+
+	printf("I found %1.0lf Zeros in %.3lf seconds\n",count,(t2-t1)/1000000.0);
+	if (prec_ladder)
+		printf("Precision : %1.0lf samples in double-double, %1.0lf in %s, %1.0lf unresolved\n",
+			prec_count[0], prec_count[1], F128_NAME, prec_count[2]);
+	if (certify)
+		turing_certify(LOWER, UPPER, count);
+
+	free_table();
+	bsgs_free(&bsgs_last);
+	free(grid_T);
+	free(grid_H);
+
+	return(0);
+}